@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #ifdef __GNUG__
@@ -14,6 +19,39 @@
 
 #include "CpuFeatures.hpp"
 
+#ifdef BASE64_ENABLE_TELEMETRY
+#include <atomic>
+#include <mutex>
+#endif
+
+#ifdef BASE64_ENABLE_TRACING
+#include <atomic>
+#include <chrono>
+#if defined(__has_include)
+// The USDT probes need semaphores, so they're only used if <sys/sdt.h> hasn't already been included without
+// them.
+#if __has_include(<sys/sdt.h>) && (!defined(_SYS_SDT_H) || defined(_SDT_HAS_SEMAPHORES))
+#ifndef _SDT_HAS_SEMAPHORES
+#define _SDT_HAS_SEMAPHORES 1
+#endif
+#include <sys/sdt.h>
+#define BASE64_TRACING_USDT
+#endif
+#endif
+#endif
+
+#ifdef BASE64_TRACING_USDT
+// Semaphores for the USDT probes, which tracers increment while a probe is attached.  They're weak so that
+// every translation unit including this header can define them, and have C linkage as the probes refer to
+// them by name.
+extern "C" {
+    __attribute__((weak, section(".probes"))) volatile unsigned short cppbase64_encode_entry_semaphore = 0;
+    __attribute__((weak, section(".probes"))) volatile unsigned short cppbase64_encode_exit_semaphore = 0;
+    __attribute__((weak, section(".probes"))) volatile unsigned short cppbase64_decode_entry_semaphore = 0;
+    __attribute__((weak, section(".probes"))) volatile unsigned short cppbase64_decode_exit_semaphore = 0;
+}
+#endif
+
 namespace base64 {
     enum class Codepath {
         Auto = 0,
@@ -22,6 +60,31 @@ namespace base64 {
         AVX2 = 3
     };
 
+    // Input size classes used to choose a codepath when `Codepath::Auto` is requested.
+    enum class SizeClass {
+        Tiny = 0,
+        Short = 1,
+        Medium = 2,
+        Large = 3
+    };
+
+    constexpr size_t SizeClassCount = 4;
+
+    // Codepaths chosen by `Codepath::Auto` for each size class.  Lengths are those of the source data, so
+    // binary lengths are classified when encoding and base64 lengths when decoding.  Tiny inputs always use
+    // the basic codepath, so the Tiny entries must be `Codepath::Basic`.
+    struct DispatchTable {
+        // Exclusive upper bounds of the Tiny, Short and Medium classes.  Large is unbounded.
+        std::array<size_t, SizeClassCount - 1> size_limits = { 24, 512, 65536 };
+
+        std::array<Codepath, SizeClassCount> encode = {
+            Codepath::Basic, Codepath::Basic, Codepath::Basic, Codepath::Basic
+        };
+        std::array<Codepath, SizeClassCount> decode = {
+            Codepath::Basic, Codepath::Basic, Codepath::Basic, Codepath::Basic
+        };
+    };
+
     //--------------------------------------------------------------------------------------------------------
     //--------------------------------------------------------------------------------------------------------
     //--------------------------------------------------------------------------------------------------------
@@ -51,6 +114,15 @@ namespace base64 {
              0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0  // 0xF0 - 0xFF
         };
 
+        // Detects constant evaluation so that the SIMD kernels are only used at runtime.
+        constexpr bool is_constant_evaluated() noexcept {
+#ifdef __cpp_lib_is_constant_evaluated
+            return std::is_constant_evaluated();
+#else
+            return __builtin_is_constant_evaluated();
+#endif
+        }
+
         inline Codepath get_auto_codepath() {
             using namespace cpu_features;
             auto features = get_features();
@@ -63,24 +135,107 @@ namespace base64 {
             return Codepath::Basic;
         }
 
+        inline bool is_codepath_supported(Codepath codepath) {
+            using namespace cpu_features;
+            auto features = get_features();
+            switch (codepath) {
+            case Codepath::Basic: return true;
+            case Codepath::SSSE3: return (features & Features::SSSE3) != 0;
+            case Codepath::AVX2: return (features & Features::AVX2) != 0;
+            default: return false;
+            }
+        }
+
+        // Whether AVX2 is available, checked once, for the vectorized scans of the add-on headers.
+        inline bool use_avx2() {
+            static const bool supported = is_codepath_supported(Codepath::AVX2);
+            return supported;
+        }
+
+        inline DispatchTable make_default_dispatch_table(bool prefer_ssse3_for_short) {
+            Codepath best = get_auto_codepath();
+            Codepath short_codepath = best;
+            if (prefer_ssse3_for_short && best == Codepath::AVX2) {
+                short_codepath = Codepath::SSSE3;
+            }
+
+            // Tiny inputs never reach a SIMD kernel so always use the basic codepath.
+            DispatchTable table;
+            table.encode = { Codepath::Basic, short_codepath, best, best };
+            table.decode = { Codepath::Basic, short_codepath, best, best };
+            return table;
+        }
+
+        inline DispatchTable& dispatch_table() {
+            static DispatchTable s_table = make_default_dispatch_table(false);
+            return s_table;
+        }
+
+        inline SizeClass get_size_class(const DispatchTable& table, size_t length) {
+            size_t index = 0;
+            while (index < table.size_limits.size() && length >= table.size_limits[index]) {
+                index++;
+            }
+            return static_cast<SizeClass>(index);
+        }
+
+        inline Codepath get_auto_codepath(
+            const DispatchTable& table,
+            const std::array<Codepath, SizeClassCount>& codepaths,
+            size_t length
+        ) {
+            return codepaths[static_cast<size_t>(get_size_class(table, length))];
+        }
+
+        // Invokes `f` once per index in [0, Count), with the index as a compile-time constant.
+        template<typename F, size_t... Indices>
+        constexpr void unroll_impl(F& f, std::index_sequence<Indices...>) {
+            (f(std::integral_constant<size_t, Indices>{}), ...);
+        }
+
+        template<size_t Count, typename F>
+        constexpr void unroll(F f) {
+            unroll_impl(f, std::make_index_sequence<Count>{});
+        }
+
+        // Source length at and above which the SIMD kernels use non-temporal stores.
+        inline size_t& streaming_threshold() {
+            static size_t s_threshold = SIZE_MAX;
+            return s_threshold;
+        }
+
+        // Encodes a single group of three octets.  Used to align the destination of the streaming kernels.
+        inline void encode_group_basic(const uint8_t* source, uint8_t* dest) {
+            dest[0] = Base64LUT[source[0] >> 2];
+            dest[1] = Base64LUT[(source[0] & 0x03) << 4 | source[1] >> 4];
+            dest[2] = Base64LUT[(source[1] & 0x0F) << 2 | source[2] >> 6];
+            dest[3] = Base64LUT[source[2] & 0x3F];
+        }
+
+        // Decodes a single group of four characters.
+        inline void decode_group_basic(const uint8_t* source, uint8_t* dest) {
+            uint8_t b0 = Base64InverseLUT[source[0]];
+            uint8_t b1 = Base64InverseLUT[source[1]];
+            uint8_t b2 = Base64InverseLUT[source[2]];
+            uint8_t b3 = Base64InverseLUT[source[3]];
+
+            dest[0] = b0 << 2 | b1 >> 4;
+            dest[1] = b1 << 4 | b2 >> 2;
+            dest[2] = b2 << 6 | b3;
+        }
+
         //----------------------------------------------------------------------------------------------------
         //----------------------------------------------------------------------------------------------------
         //----------------------------------------------------------------------------------------------------
 
-        inline size_t encode_bulk_ssse3(
-            const uint8_t* source_data,
-            const size_t source_data_length,
-            uint8_t*& dest_ptr
-        ) {
-            size_t loop_count = (source_data_length / 12);
-            if (loop_count == 0) {
-                return 0;
-            }
+        // Constants used by the SSSE3 encoding kernel.
+        // Code based on work by Wojciech Muła
+        // Ref: http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+        struct EncodeConstantsSSSE3 {
+            // Explicitly defined so that it picks up the AVX2 target pragma; GCC does not apply it to
+            // implicitly defined constructors.
+            EncodeConstantsSSSE3() {}
 
-            size_t loop_end = (loop_count * 12);
-
-            // Code based on work by Wojciech Muła
-            // Ref: http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
             const __m128i preshuffle_128 = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
             const __m128i t0Mask   = _mm_set_epi32(0x0fc0fc00, 0x0fc0fc00, 0x0fc0fc00, 0x0fc0fc00);
             const __m128i t1Values = _mm_set_epi32(0x04000040, 0x04000040, 0x04000040, 0x04000040);
@@ -94,43 +249,61 @@ namespace base64 {
                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
                 '/' - 63, 'A', 0, 0
             );
+        };
+
+        // Encodes the low 12 octets of `b` into 16 base64 characters.
+        inline __m128i encode_block_ssse3(__m128i b, const EncodeConstantsSSSE3& c) {
+            // [?ddd|?ccc|?bbb|?aaa]
+            b = _mm_shuffle_epi8(b, c.preshuffle_128);
+
+            // t0 = [0000cccc|CC000000|aaaaaa00|00000000]
+            // t1 = [00000000|00cccccc|00000000|00aaaaaa]
+            // t2 = [00000000|00dddddd|000000bb|bbbb0000]
+            // t3 = [00dddddd|00000000|00bbbbbb|00000000]
+            // unpacked = [00dddddd|00cccccc|00bbbbbb|00aaaaaa]
+            const __m128i t0 = _mm_and_si128(b, c.t0Mask);
+            const __m128i t2 = _mm_and_si128(b, c.t2Mask);
+            const __m128i t1 = _mm_mulhi_epu16(t0, c.t1Values);
+            const __m128i t3 = _mm_mullo_epi16(t2, c.t3Values);
+            const __m128i unpacked = _mm_or_si128(t1, t3);
+
+            // Convert to base64 characters without lookup tables
+            const __m128i reduced = _mm_or_si128(
+                _mm_subs_epu8(unpacked, c._51_128),
+                _mm_and_si128(
+                    _mm_cmpgt_epi8(c._26_128, unpacked),
+                    c._13_128
+                )
+            );
+            return _mm_add_epi8(
+                _mm_shuffle_epi8(c.shiftLUT, reduced),
+                unpacked
+            );
+        }
+
+        inline size_t encode_bulk_ssse3(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            // Each block loads 16 octets but only uses 12, so stop while the load stays within the source.
+            size_t loop_count = (source_data_length >= 4) ? (source_data_length - 4) / 12 : 0;
+            if (loop_count == 0) {
+                return 0;
+            }
+
+            size_t loop_end = (loop_count * 12);
+            const EncodeConstantsSSSE3 constants;
 
             for (size_t i = 0; i < loop_end; i += 12, dest_ptr += 16) {
                 // Load four sets of octets at once.
                 // [????|dddc|ccbb|baaa]
-                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
-
-                // [?ddd|?ccc|?bbb|?aaa]
-                b = _mm_shuffle_epi8(b, preshuffle_128);
-
-                // t0 = [0000cccc|CC000000|aaaaaa00|00000000]
-                // t1 = [00000000|00cccccc|00000000|00aaaaaa]
-                // t2 = [00000000|00dddddd|000000bb|bbbb0000]
-                // t3 = [00dddddd|00000000|00bbbbbb|00000000]
-                // unpacked = [00dddddd|00cccccc|00bbbbbb|00aaaaaa]
-                const __m128i t0 = _mm_and_si128(b, t0Mask);
-                const __m128i t2 = _mm_and_si128(b, t2Mask);
-                const __m128i t1 = _mm_mulhi_epu16(t0, t1Values);
-                const __m128i t3 = _mm_mullo_epi16(t2, t3Values);
-                const __m128i unpacked = _mm_or_si128(t1, t3);
-
-                // Convert to base64 characters without lookup tables
-                const __m128i reduced = _mm_or_si128(
-                    _mm_subs_epu8(unpacked, _51_128),
-                    _mm_and_si128(
-                        _mm_cmpgt_epi8(_26_128, unpacked),
-                        _13_128
-                    )
-                );
-                const __m128i result = _mm_add_epi8(
-                    _mm_shuffle_epi8(shiftLUT, reduced),
-                    unpacked
-                );
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
 
                 // Output
                 _mm_storeu_si128(
                     reinterpret_cast<__m128i*>(dest_ptr),
-                    result
+                    encode_block_ssse3(b, constants)
                 );
             }
 
@@ -139,20 +312,12 @@ namespace base64 {
 
         //----------------------------------------------------------------------------------------------------
 
-        inline size_t encode_bulk_avx2(
-            const uint8_t* source_data,
-            const size_t source_data_length,
-            uint8_t*& dest_ptr
-        ) {
-            size_t loop_count = (source_data_length / 24);
-            if (loop_count == 0) {
-                return 0;
-            }
+        // Constants used by the AVX2 encoding kernel.
+        // Code based on work by Wojciech Muła
+        // Ref: http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+        struct EncodeConstantsAVX2 {
+            EncodeConstantsAVX2() {}
 
-            size_t loop_end = (loop_count * 24);
-
-            // Code based on work by Wojciech Muła
-            // Ref: http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
             const __m256i preshuffle_256 = _mm256_set_epi8(
                 10, 11,  9, 10,
                  7,  8,  6,  7,
@@ -178,48 +343,64 @@ namespace base64 {
                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
                 '/' - 63, 'A', 0, 0
             );
+        };
+
+        // Encodes the low 12 octets of each lane of `b` into 32 base64 characters.
+        inline __m256i encode_block_avx2(__m256i b, const EncodeConstantsAVX2& c) {
+            // b = [?hhh|?ggg|?fff|?eee|?ddd|?ccc|?bbb|?aaa]
+            b = _mm256_shuffle_epi8(b, c.preshuffle_256);
+
+            // t0 = [0000cccc|CC000000|aaaaaa00|00000000]
+            // t1 = [00000000|00cccccc|00000000|00aaaaaa]
+            // t2 = [00000000|00dddddd|000000bb|bbbb0000]
+            // t3 = [00dddddd|00000000|00bbbbbb|00000000]
+            // unpacked = [00dddddd|00cccccc|00bbbbbb|00aaaaaa]
+            const __m256i t0 = _mm256_and_si256(b, c.t0Mask);
+            const __m256i t2 = _mm256_and_si256(b, c.t2Mask);
+            const __m256i t1 = _mm256_mulhi_epu16(t0, c.t1Values);
+            const __m256i t3 = _mm256_mullo_epi16(t2, c.t3Values);
+            const __m256i unpacked = _mm256_or_si256(t1, t3);
+
+            // Convert to base64 characters without lookup tables
+            const __m256i reduced = _mm256_or_si256(
+                _mm256_subs_epu8(unpacked, c._51_256),
+                _mm256_and_si256(
+                    _mm256_cmpgt_epi8(c._26_256, unpacked),
+                    c._13_256
+                )
+            );
+            return _mm256_add_epi8(
+                _mm256_shuffle_epi8(c.shiftLUT, reduced),
+                unpacked
+            );
+        }
+
+        inline size_t encode_bulk_avx2(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            // The high half loads 16 octets at an offset of 12 but only uses 12, so stop while that load stays
+            // within the source.
+            size_t loop_count = (source_data_length >= 4) ? (source_data_length - 4) / 24 : 0;
+            if (loop_count == 0) {
+                return 0;
+            }
+
+            size_t loop_end = (loop_count * 24);
+            const EncodeConstantsAVX2 constants;
 
             for (size_t i = 0; i < loop_end; i += 24, dest_ptr += 32) {
                 // Load eight sets of octets at once.
                 // b_low  = [????|dddc|ccbb|baaa]
                 // b_high = [????|hhhg|ggff|feee]
-                __m128i b_low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
-                __m128i b_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i+12]));
-                
-                // b = [?hhh|?ggg|?fff|?eee|?ddd|?ccc|?bbb|?aaa]
-                __m256i b = _mm256_shuffle_epi8(
-                    _mm256_set_m128i(b_high, b_low),
-                    preshuffle_256
-                );
-
-                // t0 = [0000cccc|CC000000|aaaaaa00|00000000]
-                // t1 = [00000000|00cccccc|00000000|00aaaaaa]
-                // t2 = [00000000|00dddddd|000000bb|bbbb0000]
-                // t3 = [00dddddd|00000000|00bbbbbb|00000000]
-                // unpacked = [00dddddd|00cccccc|00bbbbbb|00aaaaaa]
-                const __m256i t0 = _mm256_and_si256(b, t0Mask);
-                const __m256i t2 = _mm256_and_si256(b, t2Mask);
-                const __m256i t1 = _mm256_mulhi_epu16(t0, t1Values);
-                const __m256i t3 = _mm256_mullo_epi16(t2, t3Values);
-                const __m256i unpacked = _mm256_or_si256(t1, t3);
-
-                // Convert to base64 characters without lookup tables
-                const __m256i reduced = _mm256_or_si256(
-                    _mm256_subs_epu8(unpacked, _51_256),
-                    _mm256_and_si256(
-                        _mm256_cmpgt_epi8(_26_256, unpacked),
-                        _13_256
-                    )
-                );
-                const __m256i result = _mm256_add_epi8(
-                    _mm256_shuffle_epi8(shiftLUT, reduced),
-                    unpacked
-                );
+                const __m128i b_low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
+                const __m128i b_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i+12]));
 
                 // Output
                 _mm256_storeu_si256(
                     reinterpret_cast<__m256i*>(dest_ptr),
-                    result
+                    encode_block_avx2(_mm256_set_m128i(b_high, b_low), constants)
                 );
             }
 
@@ -228,15 +409,91 @@ namespace base64 {
 
         //----------------------------------------------------------------------------------------------------
 
+        // Streaming variants of the encoding kernels, which write with non-temporal stores so that very
+        // large outputs bypass the cache.  The destination is first aligned by encoding whole groups, which
+        // is only possible when it's at least 4 byte aligned; otherwise the regular kernels are used.
+        inline size_t encode_bulk_ssse3_stream(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            if (reinterpret_cast<uintptr_t>(dest_ptr) % 4 != 0) {
+                return encode_bulk_ssse3(source_data, source_data_length, dest_ptr);
+            }
+
+            size_t i = 0;
+            while ((reinterpret_cast<uintptr_t>(dest_ptr) % 16) != 0 && i + 3 <= source_data_length) {
+                encode_group_basic(&source_data[i], dest_ptr);
+                i += 3;
+                dest_ptr += 4;
+            }
+
+            const EncodeConstantsSSSE3 constants;
+            for (; i + 16 <= source_data_length; i += 12, dest_ptr += 16) {
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dest_ptr), encode_block_ssse3(b, constants));
+            }
+
+            _mm_sfence();
+            return i;
+        }
+
+        inline size_t encode_bulk_avx2_stream(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            if (reinterpret_cast<uintptr_t>(dest_ptr) % 4 != 0) {
+                return encode_bulk_avx2(source_data, source_data_length, dest_ptr);
+            }
+
+            size_t i = 0;
+            while ((reinterpret_cast<uintptr_t>(dest_ptr) % 32) != 0 && i + 3 <= source_data_length) {
+                encode_group_basic(&source_data[i], dest_ptr);
+                i += 3;
+                dest_ptr += 4;
+            }
+
+            const EncodeConstantsAVX2 constants;
+            for (; i + 28 <= source_data_length; i += 24, dest_ptr += 32) {
+                const __m128i b_low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
+                const __m128i b_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i+12]));
+                _mm256_stream_si256(
+                    reinterpret_cast<__m256i*>(dest_ptr),
+                    encode_block_avx2(_mm256_set_m128i(b_high, b_low), constants)
+                );
+            }
+
+            _mm_sfence();
+            return i;
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Runs the bulk kernel for `codepath`, resolving `Codepath::Auto` in place to the codepath used.
         inline size_t encode_bulk(
             const uint8_t* source_data,
             const size_t source_data_length,
             uint8_t*& dest_ptr,
-            Codepath codepath = Codepath::Auto
+            Codepath& codepath
         ) {
             if (codepath == Codepath::Auto) {
-                static auto auto_codepath = get_auto_codepath();
-                codepath = auto_codepath;
+                // Small input fast path; skip kernel selection entirely.
+                const auto& table = dispatch_table();
+                if (source_data_length < table.size_limits[0]) {
+                    codepath = Codepath::Basic;
+                    return 0;
+                }
+                codepath = get_auto_codepath(table, table.encode, source_data_length);
+            }
+
+            if (source_data_length >= streaming_threshold()) {
+                switch (codepath) {
+                case Codepath::SSSE3: return encode_bulk_ssse3_stream(source_data, source_data_length, dest_ptr);
+                case Codepath::AVX2: return encode_bulk_avx2_stream(source_data, source_data_length, dest_ptr);
+                default:
+                case Codepath::Basic: return 0;
+                }
             }
 
             switch (codepath) {
@@ -251,21 +508,12 @@ namespace base64 {
         //----------------------------------------------------------------------------------------------------
         //----------------------------------------------------------------------------------------------------
 
-        inline size_t decode_bulk_ssse3(
-            const uint8_t* source_data,
-            const size_t source_data_length,
-            uint8_t*& dest_ptr
-        ) {
-            size_t loop_count = (source_data_length / 16);
-            if (loop_count <= 1) {
-                return 0;
-            }
+        // Constants used by the SSSE3 decoding kernel.
+        // Code based on work by Wojciech Muła
+        // Ref: http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+        struct DecodeConstantsSSSE3 {
+            DecodeConstantsSSSE3() {}
 
-			loop_count--;
-            size_t loop_end = (loop_count * 16);
-
-            // Code based on work by Wojciech Muła
-            // Ref: http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
             const __m128i _0f_128 = _mm_set1_epi8(0x0f);
             const __m128i _2f_128 = _mm_set1_epi8(0x2f);
             const __m128i _n3_128 = _mm_set1_epi8(-3);
@@ -278,52 +526,61 @@ namespace base64 {
             const __m128i packValues1 = _mm_set_epi32(0x01400140, 0x01400140, 0x01400140, 0x01400140);
             const __m128i packValues2 = _mm_set_epi32(0x00011000, 0x00011000, 0x00011000, 0x00011000);
             const __m128i unshuffle_128 = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        };
 
-            for (size_t i = 0; i < loop_end; i += 16, dest_ptr += 12) {
-                // Load four sets of octets at once.
-                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
-
-                // Base64 characters -> 6-bit unpacked
-                const __m128i higher_nibble = _mm_and_si128(_mm_srli_epi32(b, 4), _0f_128);
-                const __m128i eq_2f = _mm_cmpeq_epi8(b, _2f_128);
-
-                const __m128i shift  = _mm_shuffle_epi8(shiftLUT, higher_nibble);
-                const __m128i t0     = _mm_add_epi8(b, shift);
-                const __m128i unpacked = _mm_add_epi8(t0, _mm_and_si128(eq_2f, _n3_128));
-
-                // 6-bit unpacked -> 8-bit packed
-                const __m128i packed = _mm_madd_epi16(
-                    _mm_maddubs_epi16(unpacked, packValues1),
-                    packValues2
-                );
+        // Decodes 16 base64 characters into 12 octets, returned in the low 12 bytes.
+        inline __m128i decode_block_ssse3(__m128i b, const DecodeConstantsSSSE3& c) {
+            // Base64 characters -> 6-bit unpacked
+            const __m128i higher_nibble = _mm_and_si128(_mm_srli_epi32(b, 4), c._0f_128);
+            const __m128i eq_2f = _mm_cmpeq_epi8(b, c._2f_128);
 
-                // 8-bit packed -> original order
-                const __m128i unshuffled = _mm_shuffle_epi8(packed, unshuffle_128);
+            const __m128i shift  = _mm_shuffle_epi8(c.shiftLUT, higher_nibble);
+            const __m128i t0     = _mm_add_epi8(b, shift);
+            const __m128i unpacked = _mm_add_epi8(t0, _mm_and_si128(eq_2f, c._n3_128));
 
-                // Output
-				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest_ptr), unshuffled);
-            }
+            // 6-bit unpacked -> 8-bit packed
+            const __m128i packed = _mm_madd_epi16(
+                _mm_maddubs_epi16(unpacked, c.packValues1),
+                c.packValues2
+            );
 
-            return loop_end;
+            // 8-bit packed -> original order
+            return _mm_shuffle_epi8(packed, c.unshuffle_128);
         }
 
-        //----------------------------------------------------------------------------------------------------
-
-        inline size_t decode_bulk_avx2(
+        inline size_t decode_bulk_ssse3(
             const uint8_t* source_data,
             const size_t source_data_length,
             uint8_t*& dest_ptr
         ) {
-            size_t loop_count = (source_data_length / 32);
+            size_t loop_count = (source_data_length / 16);
             if (loop_count <= 1) {
                 return 0;
             }
 
-			loop_count--;
-            size_t loop_end = (loop_count * 32);
+            loop_count--;
+            size_t loop_end = (loop_count * 16);
+            const DecodeConstantsSSSE3 constants;
+
+            for (size_t i = 0; i < loop_end; i += 16, dest_ptr += 12) {
+                // Load four sets of octets at once.
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i]));
+
+                // Output
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest_ptr), decode_block_ssse3(b, constants));
+            }
+
+            return loop_end;
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Constants used by the AVX2 decoding kernel.
+        // Code based on work by Wojciech Muła
+        // Ref: http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+        struct DecodeConstantsAVX2 {
+            DecodeConstantsAVX2() {}
 
-            // Code based on work by Wojciech Muła
-            // Ref: http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
             const __m256i _0f_256 = _mm256_set1_epi8(0x0f);
             const __m256i _2f_256 = _mm256_set1_epi8(0x2f);
             const __m256i _n3_256 = _mm256_set1_epi8(-3);
@@ -351,37 +608,65 @@ namespace base64 {
                 14, 13, 12,
                 -1, -1, -1, -1
             );
+        };
 
-            for (size_t i = 0; i < loop_end; i += 32, dest_ptr += 24) {
-                // Load eight sets of octets at once.
-                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&source_data[i]));
+        // Decodes 32 base64 characters into 24 octets, returned in the low 12 bytes of each lane.
+        inline __m256i decode_block_avx2(__m256i b, const DecodeConstantsAVX2& c) {
+            // Base64 characters -> 6-bit unpacked
+            const __m256i higher_nibble = _mm256_and_si256(_mm256_srli_epi32(b, 4), c._0f_256);
+            const __m256i eq_2f = _mm256_cmpeq_epi8(b, c._2f_256);
 
-                // Base64 characters -> 6-bit unpacked
-                const __m256i higher_nibble = _mm256_and_si256(_mm256_srli_epi32(b, 4), _0f_256);
-                const __m256i eq_2f = _mm256_cmpeq_epi8(b, _2f_256);
+            const __m256i shift  = _mm256_shuffle_epi8(c.shiftLUT, higher_nibble);
+            const __m256i t0     = _mm256_add_epi8(b, shift);
+            const __m256i unpacked = _mm256_add_epi8(t0, _mm256_and_si256(eq_2f, c._n3_256));
 
-                const __m256i shift  = _mm256_shuffle_epi8(shiftLUT, higher_nibble);
-                const __m256i t0     = _mm256_add_epi8(b, shift);
-                const __m256i unpacked = _mm256_add_epi8(t0, _mm256_and_si256(eq_2f, _n3_256));
+            // 6-bit unpacked -> 8-bit packed
+            const __m256i packed = _mm256_madd_epi16(
+                _mm256_maddubs_epi16(unpacked, c.packValues1),
+                c.packValues2
+            );
 
-                // 6-bit unpacked -> 8-bit packed
-                const __m256i packed = _mm256_madd_epi16(
-                    _mm256_maddubs_epi16(unpacked, packValues1),
-                    packValues2
-                );
+            // 8-bit packed -> original order
+            return _mm256_shuffle_epi8(packed, c.unshuffle_256);
+        }
+
+        // Returns a mask of the bytes of `v` in [low, high].  Bytes from 0x80 are negative, so fail every range
+        // check.
+        inline __m256i in_range_avx2(__m256i v, char low, char high) {
+            return _mm256_and_si256(
+                _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(low - 1))),
+                _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), v)
+            );
+        }
+
+        inline size_t decode_bulk_avx2(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            size_t loop_count = (source_data_length / 32);
+            if (loop_count <= 1) {
+                return 0;
+            }
 
-                // 8-bit packed -> original order
-                const __m256i unshuffled = _mm256_shuffle_epi8(packed, unshuffle_256);
+            loop_count--;
+            size_t loop_end = (loop_count * 32);
+            const DecodeConstantsAVX2 constants;
+
+            for (size_t i = 0; i < loop_end; i += 32, dest_ptr += 24) {
+                // Load eight sets of octets at once.
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&source_data[i]));
+                const __m256i unshuffled = decode_block_avx2(b, constants);
 
                 // Output
-				_mm_storeu_si128(
-					reinterpret_cast<__m128i*>(dest_ptr),
-					_mm256_extracti128_si256(unshuffled, 0)
-				);
-				_mm_storeu_si128(
-					reinterpret_cast<__m128i*>(dest_ptr+12),
-					_mm256_extracti128_si256(unshuffled, 1)
-				);
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(dest_ptr),
+                    _mm256_extracti128_si256(unshuffled, 0)
+                );
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(dest_ptr+12),
+                    _mm256_extracti128_si256(unshuffled, 1)
+                );
             }
 
             return loop_end;
@@ -389,15 +674,106 @@ namespace base64 {
 
         //----------------------------------------------------------------------------------------------------
 
+        // Streaming variants of the decoding kernels.  Decoded blocks are not a multiple of the vector size,
+        // so four blocks at a time are decoded into a staging buffer in L1 and then written out with aligned
+        // non-temporal stores.  The destination is first aligned by decoding whole groups.  As with the
+        // regular kernels the final group, which may hold padding, is left for the scalar loop.
+        inline size_t decode_bulk_ssse3_stream(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            size_t i = 0;
+            while ((reinterpret_cast<uintptr_t>(dest_ptr) % 16) != 0 && i + 8 <= source_data_length) {
+                decode_group_basic(&source_data[i], dest_ptr);
+                i += 4;
+                dest_ptr += 3;
+            }
+
+            const DecodeConstantsSSSE3 constants;
+            alignas(16) uint8_t stage[48 + 4];
+            for (; i + 64 + 4 <= source_data_length; i += 64, dest_ptr += 48) {
+                unroll<4>([&](auto block) {
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source_data[i + block * 16]));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&stage[block * 12]), decode_block_ssse3(b, constants));
+                });
+                unroll<3>([&](auto part) {
+                    _mm_stream_si128(
+                        reinterpret_cast<__m128i*>(dest_ptr + part * 16),
+                        _mm_load_si128(reinterpret_cast<const __m128i*>(&stage[part * 16]))
+                    );
+                });
+            }
+
+            _mm_sfence();
+            return i;
+        }
+
+        inline size_t decode_bulk_avx2_stream(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            uint8_t*& dest_ptr
+        ) {
+            size_t i = 0;
+            while ((reinterpret_cast<uintptr_t>(dest_ptr) % 32) != 0 && i + 8 <= source_data_length) {
+                decode_group_basic(&source_data[i], dest_ptr);
+                i += 4;
+                dest_ptr += 3;
+            }
+
+            const DecodeConstantsAVX2 constants;
+            alignas(32) uint8_t stage[96 + 4];
+            for (; i + 128 + 4 <= source_data_length; i += 128, dest_ptr += 96) {
+                unroll<4>([&](auto block) {
+                    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&source_data[i + block * 32]));
+                    const __m256i unshuffled = decode_block_avx2(b, constants);
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(&stage[block * 24]),
+                        _mm256_extracti128_si256(unshuffled, 0)
+                    );
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(&stage[block * 24 + 12]),
+                        _mm256_extracti128_si256(unshuffled, 1)
+                    );
+                });
+                unroll<3>([&](auto part) {
+                    _mm256_stream_si256(
+                        reinterpret_cast<__m256i*>(dest_ptr + part * 32),
+                        _mm256_load_si256(reinterpret_cast<const __m256i*>(&stage[part * 32]))
+                    );
+                });
+            }
+
+            _mm_sfence();
+            return i;
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Runs the bulk kernel for `codepath`, resolving `Codepath::Auto` in place to the codepath used.
         inline size_t decode_bulk(
             const uint8_t* source_data,
             const size_t source_data_length,
             uint8_t*& dest_ptr,
-            Codepath codepath = Codepath::Auto
+            Codepath& codepath
         ) {
             if (codepath == Codepath::Auto) {
-                static auto auto_codepath = get_auto_codepath();
-                codepath = auto_codepath;
+                // Small input fast path; skip kernel selection entirely.
+                const auto& table = dispatch_table();
+                if (source_data_length < table.size_limits[0]) {
+                    codepath = Codepath::Basic;
+                    return 0;
+                }
+                codepath = get_auto_codepath(table, table.decode, source_data_length);
+            }
+
+            if (source_data_length >= streaming_threshold()) {
+                switch (codepath) {
+                case Codepath::SSSE3: return decode_bulk_ssse3_stream(source_data, source_data_length, dest_ptr);
+                case Codepath::AVX2: return decode_bulk_avx2_stream(source_data, source_data_length, dest_ptr);
+                default:
+                case Codepath::Basic: return 0;
+                }
             }
 
             switch (codepath) {
@@ -413,8 +789,358 @@ namespace base64 {
     //--------------------------------------------------------------------------------------------------------
     //--------------------------------------------------------------------------------------------------------
 
+    // Returns true if the codepath can be used on the current CPU.  `Codepath::Auto` is always supported.
+    inline bool is_codepath_supported(Codepath codepath) {
+        return codepath == Codepath::Auto || detail::is_codepath_supported(codepath);
+    }
+
+    // Builds the built-in dispatch table for the current CPU.  Tiny inputs use the basic codepath and all
+    // others the fastest available.  `prefer_ssse3_for_short` keeps short inputs on SSSE3 even when AVX2 is
+    // available, avoiding AVX frequency license transitions for short, infrequent calls.
+    inline DispatchTable make_default_dispatch_table(bool prefer_ssse3_for_short = false) {
+        return detail::make_default_dispatch_table(prefer_ssse3_for_short);
+    }
+
+    // Returns the dispatch table currently used by `Codepath::Auto`.
+    inline const DispatchTable& get_dispatch_table() {
+        return detail::dispatch_table();
+    }
+
+    // Replaces the dispatch table used by `Codepath::Auto`.  This is not synchronized with concurrent calls,
+    // so should be done during startup before any encoding or decoding takes place.  Throws
+    // std::invalid_argument if the size limits aren't ascending, a codepath isn't supported, or a Tiny entry
+    // isn't `Codepath::Basic`.
+    inline void set_dispatch_table(const DispatchTable& table) {
+        for (size_t i = 1; i < table.size_limits.size(); ++i) {
+            if (table.size_limits[i] < table.size_limits[i-1]) {
+                throw std::invalid_argument("Size limits must be ascending");
+            }
+        }
+        constexpr size_t tiny = static_cast<size_t>(SizeClass::Tiny);
+        if (table.encode[tiny] != Codepath::Basic || table.decode[tiny] != Codepath::Basic) {
+            throw std::invalid_argument("Tiny inputs always use the basic codepath");
+        }
+        for (size_t i = 0; i < SizeClassCount; ++i) {
+            if (!detail::is_codepath_supported(table.encode[i]) || !detail::is_codepath_supported(table.decode[i])) {
+                throw std::invalid_argument("Codepath is not supported");
+            }
+        }
+
+        detail::dispatch_table() = table;
+    }
+
+    // Returns the size class that `Codepath::Auto` will use for a source of the given length.
+    inline SizeClass get_size_class(size_t length) {
+        return detail::get_size_class(detail::dispatch_table(), length);
+    }
+
+    // Sets the source length at and above which the SSSE3 and AVX2 codepaths write with non-temporal
+    // streaming stores.  Very large outputs then bypass the cache rather than evicting the working sets of
+    // everything else on the machine, but are slower to read back immediately.  Zero streams every call and
+    // SIZE_MAX, the default, never streams.  Like `set_dispatch_table`, this should be done during startup.
+    inline void set_streaming_threshold(size_t source_length) {
+        detail::streaming_threshold() = source_length;
+    }
+
+    inline size_t get_streaming_threshold() {
+        return detail::streaming_threshold();
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // True when compiled with BASE64_ENABLE_TELEMETRY defined.  Otherwise no counters are kept, recording
+    // compiles away entirely and `get_telemetry` always returns zeros.
+#ifdef BASE64_ENABLE_TELEMETRY
+    constexpr bool TelemetryEnabled = true;
+#else
+    constexpr bool TelemetryEnabled = false;
+#endif
+
+    // Number of buckets in the telemetry size histogram.  Bucket 0 counts empty sources and bucket i counts
+    // lengths in [2^(i-1), 2^i).  The last bucket also counts anything larger.
+    constexpr size_t TelemetryBucketCount = 48;
+
+    // Telemetry for one direction.  Lengths are those of the source data, so binary lengths when encoding
+    // and base64 lengths when decoding.
+    struct TelemetryCounters {
+        uint64_t calls = 0;
+        uint64_t bytes = 0;
+
+        // Source bytes handled by the SIMD kernels, and by the scalar loop and remainder handling.
+        uint64_t bulk_bytes = 0;
+        uint64_t scalar_bytes = 0;
+
+        // Calls per codepath actually used, indexed by `Codepath`.  `Codepath::Auto` is always zero.
+        std::array<uint64_t, 4> codepath_calls = {};
+
+        std::array<uint64_t, TelemetryBucketCount> size_histogram = {};
+    };
+
+    struct TelemetrySnapshot {
+        TelemetryCounters encode;
+        TelemetryCounters decode;
+    };
+
+    namespace detail {
+        inline size_t get_telemetry_bucket(size_t length) {
+            size_t bucket = 0;
+            if (length != 0) {
+#ifdef _MSC_VER
+                unsigned long index = 0;
+                _BitScanReverse64(&index, length);
+                bucket = index + 1;
+#else
+                bucket = 64 - __builtin_clzll(length);
+#endif
+            }
+            return bucket < TelemetryBucketCount ? bucket : TelemetryBucketCount - 1;
+        }
+
+        // Calls `f` with each pair of corresponding counters of `a` and `b`.
+        template<typename A, typename B, typename F>
+        inline void for_each_telemetry_counter(A& a, B& b, F f) {
+            f(a.calls, b.calls);
+            f(a.bytes, b.bytes);
+            f(a.bulk_bytes, b.bulk_bytes);
+            f(a.scalar_bytes, b.scalar_bytes);
+            for (size_t i = 0; i < a.codepath_calls.size(); ++i) {
+                f(a.codepath_calls[i], b.codepath_calls[i]);
+            }
+            for (size_t i = 0; i < TelemetryBucketCount; ++i) {
+                f(a.size_histogram[i], b.size_histogram[i]);
+            }
+        }
+
+#ifdef BASE64_ENABLE_TELEMETRY
+        // The counters of a single thread.  Only the owning thread writes them, so increments are a plain
+        // load and store rather than a locked read-modify-write; they are atomic only so that snapshots can
+        // read them from other threads.
+        struct ThreadTelemetryCounters {
+            std::atomic<uint64_t> calls{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint64_t> bulk_bytes{ 0 };
+            std::atomic<uint64_t> scalar_bytes{ 0 };
+            std::array<std::atomic<uint64_t>, 4> codepath_calls{};
+            std::array<std::atomic<uint64_t>, TelemetryBucketCount> size_histogram{};
+        };
+
+        struct ThreadTelemetry {
+            ThreadTelemetryCounters encode;
+            ThreadTelemetryCounters decode;
+
+            ThreadTelemetry();
+            ~ThreadTelemetry();
+        };
+
+        // Tracks the counters of every live thread.  Counters are never cleared; the totals of threads that
+        // have exited are folded into `retired` and a reset records a `baseline` to subtract instead.
+        struct TelemetryRegistry {
+            std::mutex mutex;
+            std::vector<ThreadTelemetry*> threads;
+            TelemetrySnapshot retired;
+            TelemetrySnapshot baseline;
+        };
+
+        inline TelemetryRegistry& telemetry_registry() {
+            static TelemetryRegistry s_registry;
+            return s_registry;
+        }
+
+        inline void add_thread_telemetry(TelemetrySnapshot& total, const ThreadTelemetry& thread) {
+            auto add = [](uint64_t& sum, const std::atomic<uint64_t>& value) {
+                sum += value.load(std::memory_order_relaxed);
+            };
+            for_each_telemetry_counter(total.encode, thread.encode, add);
+            for_each_telemetry_counter(total.decode, thread.decode, add);
+        }
+
+        inline ThreadTelemetry::ThreadTelemetry() {
+            auto& registry = telemetry_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(this);
+        }
+
+        inline ThreadTelemetry::~ThreadTelemetry() {
+            auto& registry = telemetry_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            add_thread_telemetry(registry.retired, *this);
+            for (auto& thread : registry.threads) {
+                if (thread == this) {
+                    thread = registry.threads.back();
+                    registry.threads.pop_back();
+                    break;
+                }
+            }
+        }
+
+        inline ThreadTelemetry& thread_telemetry() {
+            thread_local ThreadTelemetry s_telemetry;
+            return s_telemetry;
+        }
+
+        inline void increment(std::atomic<uint64_t>& counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        inline void record(ThreadTelemetryCounters& counters, Codepath codepath, size_t length, size_t bulk_length) {
+            increment(counters.calls, 1);
+            increment(counters.bytes, length);
+            increment(counters.bulk_bytes, bulk_length);
+            increment(counters.scalar_bytes, length - bulk_length);
+            increment(counters.codepath_calls[static_cast<size_t>(codepath) & 3], 1);
+            increment(counters.size_histogram[get_telemetry_bucket(length)], 1);
+        }
+
+        inline void record_encode(Codepath codepath, size_t length, size_t bulk_length) {
+            record(thread_telemetry().encode, codepath, length, bulk_length);
+        }
+
+        inline void record_decode(Codepath codepath, size_t length, size_t bulk_length) {
+            record(thread_telemetry().decode, codepath, length, bulk_length);
+        }
+
+        inline TelemetrySnapshot get_telemetry_totals(TelemetryRegistry& registry) {
+            TelemetrySnapshot total = registry.retired;
+            for (auto* thread : registry.threads) {
+                add_thread_telemetry(total, *thread);
+            }
+            return total;
+        }
+#else
+        inline void record_encode(Codepath, size_t, size_t) {}
+        inline void record_decode(Codepath, size_t, size_t) {}
+#endif
+    }
+
+    // Returns the telemetry counted since startup or the last `reset_telemetry`, summed over all threads.
+    // Each thread's counters are read without stopping it, so calls in progress may be partially counted.
+    inline TelemetrySnapshot get_telemetry() {
+        TelemetrySnapshot snapshot;
+#ifdef BASE64_ENABLE_TELEMETRY
+        auto& registry = detail::telemetry_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        snapshot = detail::get_telemetry_totals(registry);
+
+        auto subtract = [](uint64_t& value, const uint64_t& baseline) { value -= baseline; };
+        detail::for_each_telemetry_counter(snapshot.encode, registry.baseline.encode, subtract);
+        detail::for_each_telemetry_counter(snapshot.decode, registry.baseline.decode, subtract);
+#endif
+        return snapshot;
+    }
+
+    // Restarts the telemetry counters from zero.
+    inline void reset_telemetry() {
+#ifdef BASE64_ENABLE_TELEMETRY
+        auto& registry = detail::telemetry_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.baseline = detail::get_telemetry_totals(registry);
+#endif
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // True when compiled with BASE64_ENABLE_TRACING defined.  Otherwise the trace points compile away
+    // entirely and a registered callback is never called.
+#ifdef BASE64_ENABLE_TRACING
+    constexpr bool TracingEnabled = true;
+#else
+    constexpr bool TracingEnabled = false;
+#endif
+
+    enum class TracePoint {
+        EncodeEntry,
+        EncodeExit,
+        DecodeEntry,
+        DecodeExit
+    };
+
+    // Passed to the trace callback at entry to, and exit from, `encode` and `decode`.  The codepath is the
+    // one requested on entry and the one used on exit, so `Codepath::Auto` is resolved by then.
+    struct TraceEvent {
+        TracePoint point = TracePoint::EncodeEntry;
+        size_t length = 0;  // Source length
+        Codepath codepath = Codepath::Auto;
+        uint64_t timestamp = 0;  // std::chrono::steady_clock nanoseconds
+    };
+
+    using TraceCallback = void (*)(const TraceEvent& event);
+
+    namespace detail {
+#ifdef BASE64_ENABLE_TRACING
+        inline std::atomic<TraceCallback>& trace_callback() {
+            static std::atomic<TraceCallback> s_callback{ nullptr };
+            return s_callback;
+        }
+
+        // Whether a tracer is attached to the USDT probe for `point`.
+        inline bool is_trace_probe_enabled(TracePoint point) {
+#ifdef BASE64_TRACING_USDT
+            switch (point) {
+            case TracePoint::EncodeEntry: return cppbase64_encode_entry_semaphore != 0;
+            case TracePoint::EncodeExit: return cppbase64_encode_exit_semaphore != 0;
+            case TracePoint::DecodeEntry: return cppbase64_decode_entry_semaphore != 0;
+            case TracePoint::DecodeExit: return cppbase64_decode_exit_semaphore != 0;
+            }
+            return false;
+#else
+            (void)point;
+            return false;
+#endif
+        }
+
+        // Calls the registered callback and fires the matching USDT probe, if <sys/sdt.h> is available.
+        // The probes are `cppbase64:encode_entry` etc, with the length, codepath and timestamp as arguments.
+        // Nothing is timed unless a callback is registered or a tracer is attached.
+        inline void trace(TracePoint point, size_t length, Codepath codepath) {
+            TraceCallback callback = trace_callback().load(std::memory_order_relaxed);
+            if (!callback && !is_trace_probe_enabled(point)) {
+                return;
+            }
+
+            TraceEvent event;
+            event.point = point;
+            event.length = length;
+            event.codepath = codepath;
+            event.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count());
+
+#ifdef BASE64_TRACING_USDT
+            int codepath_value = static_cast<int>(codepath);
+            switch (point) {
+            case TracePoint::EncodeEntry: DTRACE_PROBE3(cppbase64, encode_entry, length, codepath_value, event.timestamp); break;
+            case TracePoint::EncodeExit: DTRACE_PROBE3(cppbase64, encode_exit, length, codepath_value, event.timestamp); break;
+            case TracePoint::DecodeEntry: DTRACE_PROBE3(cppbase64, decode_entry, length, codepath_value, event.timestamp); break;
+            case TracePoint::DecodeExit: DTRACE_PROBE3(cppbase64, decode_exit, length, codepath_value, event.timestamp); break;
+            }
+#endif
+
+            if (callback) {
+                callback(event);
+            }
+        }
+#else
+        inline void trace(TracePoint, size_t, Codepath) {}
+#endif
+    }
+
+    // Registers a function called at entry to and exit from every `encode` and `decode` made at runtime, or
+    // unregisters it when null.  Only has an effect when tracing is enabled.  The callback may be called on
+    // any thread, and should be cheap as it's on the hot path.
+    inline void set_trace_callback(TraceCallback callback) {
+#ifdef BASE64_ENABLE_TRACING
+        detail::trace_callback().store(callback, std::memory_order_relaxed);
+#else
+        (void)callback;
+#endif
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
     // Helper to determine the size of an encoded base64 buffer.
-    inline size_t get_encoded_length(size_t binary_length, bool padded = true) {
+    constexpr size_t get_encoded_length(size_t binary_length, bool padded = true) {
         if (padded) {
             return (binary_length + 2) / 3 * 4;
         } else {
@@ -427,8 +1153,15 @@ namespace base64 {
         }
     }
 
+    namespace detail {
+        // The length of the final group of an encoded message, which may be padded or partial.
+        constexpr size_t get_final_group_length(size_t encoded_length) {
+            return (encoded_length % 4) ? (encoded_length % 4) : std::min<size_t>(encoded_length, 4);
+        }
+    }
+
     // Helper to determine the size of a decoded binary buffer, given the source base64 data.
-    inline size_t get_decoded_length(const uint8_t* data, const size_t data_length) {
+    constexpr size_t get_decoded_length(const uint8_t* data, const size_t data_length) {
         if (data_length == 0) {
             return 0;
         }
@@ -456,7 +1189,8 @@ namespace base64 {
     //--------------------------------------------------------------------------------------------------------
 
     // Primary base64 encoding method.  Asserts that the destination buffer is _exactly_ the required size.
-    inline void encode(
+    // Usable in constant expressions, in which case only the basic codepath is used.
+    constexpr void encode(
         const uint8_t* source_data,
         const size_t source_data_length,
         uint8_t* dest_data,
@@ -470,7 +1204,12 @@ namespace base64 {
 
         // Use bulk vectorized encoding for as much data as possible.
         auto dest_ptr = dest_data;
-        size_t loop_end = detail::encode_bulk(source_data, source_data_length, dest_ptr, codepath);
+        size_t loop_end = 0;
+        if (!detail::is_constant_evaluated()) {
+            detail::trace(TracePoint::EncodeEntry, source_data_length, codepath);
+            loop_end = detail::encode_bulk(source_data, source_data_length, dest_ptr, codepath);
+            detail::record_encode(codepath, source_data_length, loop_end);
+        }
 
         size_t remainder = source_data_length - loop_end;
         size_t octet_count = (remainder / 3);
@@ -512,6 +1251,10 @@ namespace base64 {
                 dest_ptr[3] = '=';
             }
         }
+
+        if (!detail::is_constant_evaluated()) {
+            detail::trace(TracePoint::EncodeExit, source_data_length, codepath);
+        }
     }
 
     //--------------------------------------------------------------------------------------------------------
@@ -569,7 +1312,8 @@ namespace base64 {
     //--------------------------------------------------------------------------------------------------------
 
     // Primary base64 decoding method.  Asserts that the destination buffer is _exactly_ the required size.
-    inline void decode(
+    // Usable in constant expressions, in which case only the basic codepath is used.
+    constexpr void decode(
         const uint8_t* source_data,
         const size_t source_data_length,
         uint8_t* dest_data,
@@ -582,7 +1326,12 @@ namespace base64 {
         }
 
         auto dest_ptr = dest_data;
-        size_t loop_end = detail::decode_bulk(source_data, source_data_length, dest_ptr, codepath);
+        size_t loop_end = 0;
+        if (!detail::is_constant_evaluated()) {
+            detail::trace(TracePoint::DecodeEntry, source_data_length, codepath);
+            loop_end = detail::decode_bulk(source_data, source_data_length, dest_ptr, codepath);
+            detail::record_decode(codepath, source_data_length, loop_end);
+        }
 
         size_t binary_remainder = dest_data_length - std::distance(dest_data, dest_ptr);
         size_t octet_count = binary_remainder / 3;
@@ -616,6 +1365,10 @@ namespace base64 {
 
             dest_ptr[0] = b0 << 2 | b1 >> 4;
         }
+
+        if (!detail::is_constant_evaluated()) {
+            detail::trace(TracePoint::DecodeExit, source_data_length, codepath);
+        }
     }
 
     //--------------------------------------------------------------------------------------------------------
@@ -662,4 +1415,377 @@ namespace base64 {
         return buf;
     }
 
+    //--------------------------------------------------------------------------------------------------------
+
+    // Decodes bytes [offset, offset + length) of the binary data encoded in `source_data` into `dest_data`,
+    // reading only the characters of the groups covering that range.  Every group of four characters decodes
+    // to exactly three bytes, so a slice of a large encoding can be decoded without decoding everything
+    // before it.  Throws std::out_of_range if the range extends past the end of the decoded data.
+    inline void decode_range(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        size_t offset,
+        size_t length,
+        uint8_t* dest_data,
+        Codepath codepath = Codepath::Auto
+    ) {
+        size_t binary_length = get_decoded_length(source_data, source_data_length);
+        if (offset > binary_length || length > binary_length - offset) {
+            throw std::out_of_range("Range is outside the decoded data");
+        }
+
+        // Decodes a single group, which may be the padded or partial group at the end, into `group`.
+        uint8_t group[3];
+        auto decode_group = [&](size_t index) {
+            const uint8_t* group_data = source_data + index * 4;
+            size_t group_length = std::min<size_t>(source_data_length - index * 4, 4);
+            decode(group_data, group_length, group, get_decoded_length(group_data, group_length), Codepath::Basic);
+        };
+
+        // A group only partly in the range at the start.
+        size_t index = offset / 3;
+        size_t skip = offset % 3;
+        if (skip != 0 && length != 0) {
+            decode_group(index);
+            size_t count = std::min(3 - skip, length);
+            std::memcpy(dest_data, group + skip, count);
+            dest_data += count;
+            length -= count;
+            index++;
+        }
+
+        // Groups wholly in the range, which can't contain padding as each decodes to three bytes.
+        size_t whole_groups = length / 3;
+        if (whole_groups != 0) {
+            decode(source_data + index * 4, whole_groups * 4, dest_data, whole_groups * 3, codepath);
+            dest_data += whole_groups * 3;
+            length -= whole_groups * 3;
+            index += whole_groups;
+        }
+
+        // A group only partly in the range at the end.
+        if (length != 0) {
+            decode_group(index);
+            std::memcpy(dest_data, group, length);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    namespace detail {
+        // Overwrites the trailing characters of a fixed-size encoding with padding.  The kernels encode the
+        // partial group as if it were zero-filled, so only the padding itself needs patching.
+        template<size_t N, bool Padded>
+        constexpr void apply_fixed_padding(char* dest_data) {
+            constexpr size_t group_end = (N / 3) * 4;
+            if constexpr (Padded && (N % 3) == 1) {
+                dest_data[group_end + 2] = '=';
+                dest_data[group_end + 3] = '=';
+            } else if constexpr (Padded && (N % 3) == 2) {
+                dest_data[group_end + 3] = '=';
+            }
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        template<size_t N, bool Padded>
+        constexpr void encode_fixed_basic(const uint8_t* source_data, char* dest_data) {
+            // Each group is packed into a single 24-bit word and split into four 6-bit indices.
+            unroll<N / 3>([&](auto i) {
+                const uint32_t word =
+                    uint32_t(source_data[i * 3    ]) << 16 |
+                    uint32_t(source_data[i * 3 + 1]) <<  8 |
+                    uint32_t(source_data[i * 3 + 2]);
+
+                dest_data[i * 4    ] = Base64LUT[(word >> 18)       ];
+                dest_data[i * 4 + 1] = Base64LUT[(word >> 12) & 0x3F];
+                dest_data[i * 4 + 2] = Base64LUT[(word >>  6) & 0x3F];
+                dest_data[i * 4 + 3] = Base64LUT[(word      ) & 0x3F];
+            });
+
+            constexpr size_t octet_end = (N / 3) * 3;
+            constexpr size_t group_end = (N / 3) * 4;
+            if constexpr ((N % 3) == 2) {
+                const uint8_t b0 = source_data[octet_end  ];
+                const uint8_t b1 = source_data[octet_end+1];
+
+                dest_data[group_end    ] = Base64LUT[b0 >> 2];
+                dest_data[group_end + 1] = Base64LUT[(b0 & 0x03) << 4 | b1 >> 4];
+                dest_data[group_end + 2] = Base64LUT[(b1 & 0x0F) << 2];
+            } else if constexpr ((N % 3) == 1) {
+                const uint8_t b0 = source_data[octet_end];
+
+                dest_data[group_end    ] = Base64LUT[b0 >> 2];
+                dest_data[group_end + 1] = Base64LUT[(b0 & 0x03) << 4];
+            }
+
+            apply_fixed_padding<N, Padded>(dest_data);
+        }
+
+        template<size_t N, bool Padded>
+        inline void encode_fixed_ssse3(const uint8_t* source_data, char* dest_data) {
+            constexpr size_t block_count = (N + 11) / 12;
+
+            // Stage the input so that every 16 byte load stays in bounds and the final partial group is
+            // zero-filled.
+            uint8_t source[block_count * 12 + 4] = {};
+            std::memcpy(source, source_data, N);
+            alignas(16) uint8_t dest[block_count * 16];
+
+            const EncodeConstantsSSSE3 constants;
+            unroll<block_count>([&](auto i) {
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i * 12]));
+                _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i * 16]), encode_block_ssse3(b, constants));
+            });
+
+            std::memcpy(dest_data, dest, get_encoded_length(N, Padded));
+            apply_fixed_padding<N, Padded>(dest_data);
+        }
+
+        template<size_t N, bool Padded>
+        inline void encode_fixed_avx2(const uint8_t* source_data, char* dest_data) {
+            constexpr size_t block_count = (N + 23) / 24;
+
+            // Stage the input so that every 16 byte load stays in bounds and the final partial group is
+            // zero-filled.
+            uint8_t source[block_count * 24 + 4] = {};
+            std::memcpy(source, source_data, N);
+            alignas(32) uint8_t dest[block_count * 32];
+
+            const EncodeConstantsAVX2 constants;
+            unroll<block_count>([&](auto i) {
+                const __m128i b_low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i * 24]));
+                const __m128i b_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i * 24 + 12]));
+                _mm256_store_si256(
+                    reinterpret_cast<__m256i*>(&dest[i * 32]),
+                    encode_block_avx2(_mm256_set_m128i(b_high, b_low), constants)
+                );
+            });
+
+            std::memcpy(dest_data, dest, get_encoded_length(N, Padded));
+            apply_fixed_padding<N, Padded>(dest_data);
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        template<size_t N>
+        constexpr void decode_fixed_basic(const uint8_t* source_data, uint8_t* dest_data) {
+            // Each group of four characters is packed into a single 24-bit word and split into octets.
+            unroll<N / 3>([&](auto i) {
+                const uint32_t word =
+                    uint32_t(Base64InverseLUT[source_data[i * 4    ]]) << 18 |
+                    uint32_t(Base64InverseLUT[source_data[i * 4 + 1]]) << 12 |
+                    uint32_t(Base64InverseLUT[source_data[i * 4 + 2]]) <<  6 |
+                    uint32_t(Base64InverseLUT[source_data[i * 4 + 3]]);
+
+                dest_data[i * 3    ] = uint8_t(word >> 16);
+                dest_data[i * 3 + 1] = uint8_t(word >>  8);
+                dest_data[i * 3 + 2] = uint8_t(word      );
+            });
+
+            constexpr size_t octet_end = (N / 3) * 3;
+            constexpr size_t group_end = (N / 3) * 4;
+            if constexpr ((N % 3) == 2) {
+                const uint8_t b0 = Base64InverseLUT[source_data[group_end  ]];
+                const uint8_t b1 = Base64InverseLUT[source_data[group_end+1]];
+                const uint8_t b2 = Base64InverseLUT[source_data[group_end+2]];
+
+                dest_data[octet_end    ] = uint8_t(b0 << 2 | b1 >> 4);
+                dest_data[octet_end + 1] = uint8_t(b1 << 4 | b2 >> 2);
+            } else if constexpr ((N % 3) == 1) {
+                const uint8_t b0 = Base64InverseLUT[source_data[group_end  ]];
+                const uint8_t b1 = Base64InverseLUT[source_data[group_end+1]];
+
+                dest_data[octet_end] = uint8_t(b0 << 2 | b1 >> 4);
+            }
+        }
+
+        template<size_t N>
+        inline void decode_fixed_ssse3(const uint8_t* source_data, uint8_t* dest_data) {
+            constexpr size_t length = get_encoded_length(N, false);
+            constexpr size_t block_count = (length + 15) / 16;
+
+            // Stage the significant characters, filling the remainder of the last block with a valid
+            // character.  The octets that filler decodes to are never copied out.
+            uint8_t source[block_count * 16];
+            std::memset(source + length, 'A', sizeof(source) - length);
+            std::memcpy(source, source_data, length);
+            uint8_t dest[block_count * 12 + 4];
+
+            const DecodeConstantsSSSE3 constants;
+            unroll<block_count>([&](auto i) {
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i * 16]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i * 12]), decode_block_ssse3(b, constants));
+            });
+
+            std::memcpy(dest_data, dest, N);
+        }
+
+        template<size_t N>
+        inline void decode_fixed_avx2(const uint8_t* source_data, uint8_t* dest_data) {
+            constexpr size_t length = get_encoded_length(N, false);
+            constexpr size_t block_count = (length + 31) / 32;
+
+            // Stage the significant characters, filling the remainder of the last block with a valid
+            // character.  The octets that filler decodes to are never copied out.
+            uint8_t source[block_count * 32];
+            std::memset(source + length, 'A', sizeof(source) - length);
+            std::memcpy(source, source_data, length);
+            uint8_t dest[block_count * 24 + 8];
+
+            const DecodeConstantsAVX2 constants;
+            unroll<block_count>([&](auto i) {
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&source[i * 32]));
+                const __m256i unshuffled = decode_block_avx2(b, constants);
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(&dest[i * 24]),
+                    _mm256_extracti128_si256(unshuffled, 0)
+                );
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(&dest[i * 24 + 12]),
+                    _mm256_extracti128_si256(unshuffled, 1)
+                );
+            });
+
+            std::memcpy(dest_data, dest, N);
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        template<size_t N, bool Padded>
+        inline void encode_fixed_dispatch(const uint8_t* source_data, char* dest_data, Codepath codepath) {
+            if (codepath == Codepath::Auto) {
+                const auto& table = dispatch_table();
+                codepath = get_auto_codepath(table, table.encode, N);
+            }
+
+            record_encode(codepath, N, codepath == Codepath::Basic ? 0 : N);
+
+            switch (codepath) {
+            case Codepath::SSSE3: encode_fixed_ssse3<N, Padded>(source_data, dest_data); break;
+            case Codepath::AVX2: encode_fixed_avx2<N, Padded>(source_data, dest_data); break;
+            default:
+            case Codepath::Basic: encode_fixed_basic<N, Padded>(source_data, dest_data); break;
+            }
+        }
+
+        template<size_t N>
+        inline void decode_fixed_dispatch(const uint8_t* source_data, uint8_t* dest_data, Codepath codepath) {
+            if (codepath == Codepath::Auto) {
+                const auto& table = dispatch_table();
+                codepath = get_auto_codepath(table, table.decode, get_encoded_length(N));
+            }
+
+            // Only the significant characters are read.
+            constexpr size_t length = get_encoded_length(N, false);
+            record_decode(codepath, length, codepath == Codepath::Basic ? 0 : length);
+
+            switch (codepath) {
+            case Codepath::SSSE3: decode_fixed_ssse3<N>(source_data, dest_data); break;
+            case Codepath::AVX2: decode_fixed_avx2<N>(source_data, dest_data); break;
+            default:
+            case Codepath::Basic: decode_fixed_basic<N>(source_data, dest_data); break;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes exactly N octets into a fixed-size array.  The kernel is fully unrolled for that size, avoiding
+    // the loop and remainder handling of `encode`.  Intended for digests, UUIDs, keys and similar values.
+    template<size_t N, bool Padded = true>
+    constexpr std::array<char, get_encoded_length(N, Padded)> encode_fixed(
+        const uint8_t* source_data,
+        Codepath codepath = Codepath::Auto
+    ) {
+        std::array<char, get_encoded_length(N, Padded)> result{};
+        if constexpr (N != 0) {
+            if (detail::is_constant_evaluated()) {
+                detail::encode_fixed_basic<N, Padded>(source_data, result.data());
+            } else {
+                detail::encode_fixed_dispatch<N, Padded>(source_data, result.data(), codepath);
+            }
+        }
+        return result;
+    }
+
+    template<bool Padded = true, size_t N>
+    constexpr std::array<char, get_encoded_length(N, Padded)> encode_fixed(
+        const std::array<uint8_t, N>& source,
+        Codepath codepath = Codepath::Auto
+    ) {
+        return encode_fixed<N, Padded>(source.data(), codepath);
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Decodes exactly N octets into a fixed-size array.  Only the significant characters are read, so the
+    // source may be either padded or unpadded.
+    template<size_t N>
+    constexpr std::array<uint8_t, N> decode_fixed(
+        const uint8_t* source_data,
+        Codepath codepath = Codepath::Auto
+    ) {
+        std::array<uint8_t, N> result{};
+        if constexpr (N != 0) {
+            if (detail::is_constant_evaluated()) {
+                detail::decode_fixed_basic<N>(source_data, result.data());
+            } else {
+                detail::decode_fixed_dispatch<N>(source_data, result.data(), codepath);
+            }
+        }
+        return result;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L) && defined(__cpp_consteval)
+    namespace detail {
+        // A string literal captured as a template argument, excluding the null terminator.
+        template<size_t N>
+        struct LiteralString {
+            constexpr LiteralString(const char (&str)[N]) {
+                for (size_t i = 0; i < length; ++i) {
+                    data[i] = static_cast<uint8_t>(str[i]);
+                }
+            }
+
+            static constexpr size_t length = N - 1;
+            uint8_t data[N] = {};
+        };
+    }
+
+    // User-defined literals for compile-time encoding and decoding.  Requires C++20.
+    //   "foobar"_b64     -> std::array<char, 8>    { 'Z', 'm', '9', 'v', 'Y', 'm', 'F', 'y' }
+    //   "Zm9vYmFy"_unb64 -> std::array<uint8_t, 6> { 'f', 'o', 'o', 'b', 'a', 'r' }
+    namespace literals {
+        template<detail::LiteralString Str>
+        consteval auto operator""_b64() {
+            constexpr size_t length = get_encoded_length(Str.length);
+
+            std::array<uint8_t, length> buf{};
+            encode(Str.data, Str.length, buf.data(), length);
+
+            std::array<char, length> result{};
+            for (size_t i = 0; i < length; ++i) {
+                result[i] = static_cast<char>(buf[i]);
+            }
+            return result;
+        }
+
+        template<detail::LiteralString Str>
+        consteval auto operator""_unb64() {
+            constexpr size_t length = get_decoded_length(Str.data, Str.length);
+
+            std::array<uint8_t, length> result{};
+            decode(Str.data, Str.length, result.data(), length);
+            return result;
+        }
+    }
+#endif
+
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Base64.hpp"
+
+namespace base64 {
+
+    namespace detail {
+        // Format version written at the start of an exported dispatch table.
+        constexpr std::string_view CalibrationHeader{ "cppbase64-dispatch-1" };
+
+        // Number of timed samples taken per codepath and size class.  The fastest sample is used.
+        constexpr int CalibrationSamples = 5;
+
+        // Minimum number of bytes processed per sample, so that tiny inputs are timed over many calls.
+        constexpr size_t CalibrationBytesPerSample = 64 * 1024;
+
+        // Picks a length which represents the given size class, other than Tiny.
+        inline size_t get_calibration_length(const DispatchTable& table, size_t size_class) {
+            const auto& limits = table.size_limits;
+            if (size_class == limits.size()) {
+                return std::min<size_t>(limits.back() * 4, 1024 * 1024);
+            }
+            return (limits[size_class - 1] + limits[size_class]) / 2;
+        }
+
+        // Returns the fastest time, in nanoseconds, of `fn` over a few samples.
+        template <typename Fn>
+        inline double measure_fastest(size_t length, Fn&& fn) {
+            using namespace std::chrono;
+
+            size_t iterations = std::max<size_t>(1, CalibrationBytesPerSample / std::max<size_t>(length, 1));
+            double fastest = 0;
+            for (int sample = 0; sample < CalibrationSamples; ++sample) {
+                auto start = steady_clock::now();
+                for (size_t i = 0; i < iterations; ++i) {
+                    fn();
+                }
+                duration<double, std::nano> elapsed = steady_clock::now() - start;
+
+                double per_call = elapsed.count() / static_cast<double>(iterations);
+                if (sample == 0 || per_call < fastest) {
+                    fastest = per_call;
+                }
+            }
+            return fastest;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Microbenchmarks every supported codepath at a representative length of each size class and returns a
+    // dispatch table containing the fastest.  Tiny inputs always use the basic codepath, so that class isn't
+    // measured.  The size limits of `base` are kept.  Takes a few milliseconds.  The result is not
+    // installed; pass it to `set_dispatch_table` to use it.
+    inline DispatchTable calibrate(const DispatchTable& base = get_dispatch_table()) {
+        DispatchTable table = base;
+        table.encode[static_cast<size_t>(SizeClass::Tiny)] = Codepath::Basic;
+        table.decode[static_cast<size_t>(SizeClass::Tiny)] = Codepath::Basic;
+
+        std::vector<Codepath> codepaths;
+        for (auto codepath : { Codepath::Basic, Codepath::SSSE3, Codepath::AVX2 }) {
+            if (is_codepath_supported(codepath)) {
+                codepaths.push_back(codepath);
+            }
+        }
+
+        for (size_t size_class = static_cast<size_t>(SizeClass::Tiny) + 1; size_class < SizeClassCount; ++size_class) {
+            // Encoding is classified by binary length and decoding by base64 length.
+            size_t length = detail::get_calibration_length(table, size_class);
+            size_t binary_length = (length / 4) * 3;
+
+            std::vector<uint8_t> binary(std::max(length, binary_length));
+            for (size_t i = 0; i < binary.size(); ++i) {
+                binary[i] = static_cast<uint8_t>(i * 131 + 17);
+            }
+            std::vector<uint8_t> encoded(get_encoded_length(length));
+            std::vector<uint8_t> source = encode_to_byte_vector(binary.data(), binary_length);
+            std::vector<uint8_t> decoded(binary_length);
+
+            double fastest_encode = 0;
+            double fastest_decode = 0;
+            for (auto codepath : codepaths) {
+                double encode_time = detail::measure_fastest(length, [&] {
+                    encode(binary.data(), length, encoded.data(), encoded.size(), true, codepath);
+                });
+                double decode_time = detail::measure_fastest(source.size(), [&] {
+                    decode(source.data(), source.size(), decoded.data(), decoded.size(), codepath);
+                });
+
+                if (codepath == codepaths.front() || encode_time < fastest_encode) {
+                    fastest_encode = encode_time;
+                    table.encode[size_class] = codepath;
+                }
+                if (codepath == codepaths.front() || decode_time < fastest_decode) {
+                    fastest_decode = decode_time;
+                    table.decode[size_class] = codepath;
+                }
+            }
+        }
+
+        return table;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Serializes a dispatch table to a short single line string.  The CPU features of the current machine
+    // are included so that the result is only imported on a matching CPU.
+    inline std::string export_dispatch_table(const DispatchTable& table) {
+        std::ostringstream stream;
+        stream << detail::CalibrationHeader
+               << ' ' << std::hex << static_cast<uint64_t>(cpu_features::get_features()) << std::dec;
+        for (auto limit : table.size_limits) {
+            stream << ' ' << limit;
+        }
+        for (auto codepath : table.encode) {
+            stream << ' ' << static_cast<int>(codepath);
+        }
+        for (auto codepath : table.decode) {
+            stream << ' ' << static_cast<int>(codepath);
+        }
+        return stream.str();
+    }
+
+    // Parses a string produced by `export_dispatch_table`.  Returns nothing if the string is malformed, was
+    // exported on a CPU with different features, names a codepath that is not supported, or has a Tiny entry
+    // other than `Codepath::Basic`.
+    inline std::optional<DispatchTable> import_dispatch_table(std::string_view blob) {
+        std::istringstream stream{ std::string(blob) };
+
+        std::string header;
+        uint64_t features = 0;
+        stream >> header >> std::hex >> features >> std::dec;
+        if (!stream || header != detail::CalibrationHeader) {
+            return std::nullopt;
+        }
+        if (features != static_cast<uint64_t>(cpu_features::get_features())) {
+            return std::nullopt;
+        }
+
+        DispatchTable table;
+        for (auto& limit : table.size_limits) {
+            stream >> limit;
+        }
+        for (auto* codepaths : { &table.encode, &table.decode }) {
+            for (auto& codepath : *codepaths) {
+                int value = 0;
+                stream >> value;
+                codepath = static_cast<Codepath>(value);
+                if (codepath == Codepath::Auto || !is_codepath_supported(codepath)) {
+                    return std::nullopt;
+                }
+            }
+        }
+        if (!stream || !std::is_sorted(table.size_limits.begin(), table.size_limits.end())) {
+            return std::nullopt;
+        }
+        constexpr size_t tiny = static_cast<size_t>(SizeClass::Tiny);
+        if (table.encode[tiny] != Codepath::Basic || table.decode[tiny] != Codepath::Basic) {
+            return std::nullopt;
+        }
+
+        return table;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Writes an exported dispatch table to a file.  Returns false if the file could not be written.
+    inline bool save_dispatch_table(const std::string& path, const DispatchTable& table) {
+        std::ofstream file(path, std::ios::trunc);
+        file << export_dispatch_table(table) << '\n';
+        return static_cast<bool>(file);
+    }
+
+    // Reads a dispatch table written by `save_dispatch_table`.  Returns nothing if the file is missing or
+    // cannot be imported on this CPU.
+    inline std::optional<DispatchTable> load_dispatch_table(const std::string& path) {
+        std::ifstream file(path);
+        std::string blob;
+        if (!std::getline(file, blob)) {
+            return std::nullopt;
+        }
+        return import_dispatch_table(blob);
+    }
+
+    // Installs a dispatch table loaded from `cache_path` if possible.  Otherwise calibrates, installs the
+    // result and writes it to `cache_path` so that later process starts can skip measuring.
+    inline DispatchTable load_or_calibrate(const std::string& cache_path) {
+        auto table = load_dispatch_table(cache_path);
+        if (!table) {
+            table = calibrate();
+            save_dispatch_table(cache_path, *table);
+        }
+
+        set_dispatch_table(*table);
+        return *table;
+    }
+
+}
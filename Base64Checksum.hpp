@@ -0,0 +1,246 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+
+#include "Base64Pipeline.hpp"
+
+// Checksumming fused with encoding and decoding: the binary side of each chunk is fed to a checksum as soon as
+// it has been transcoded, while still in L1, rather than in a second pass over memory.
+
+namespace base64 {
+
+    namespace detail {
+        // Table for the bytewise software CRC32C, with the reflected Castagnoli polynomial.
+        constexpr std::array<uint32_t, 256> make_crc32c_table() {
+            std::array<uint32_t, 256> table = {};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78u : 0u);
+                }
+                table[i] = crc;
+            }
+            return table;
+        }
+
+        constexpr std::array<uint32_t, 256> Crc32cTable = make_crc32c_table();
+
+        inline bool use_sse42_crc32c() {
+            static const bool supported = (cpu_features::get_features() & cpu_features::Features::SSE4_2) != 0;
+            return supported;
+        }
+
+        inline uint32_t update_crc32c_basic(uint32_t crc, const uint8_t* data, size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                crc = (crc >> 8) ^ Crc32cTable[(crc ^ data[i]) & 0xff];
+            }
+            return crc;
+        }
+
+        // The SSE4.2 instruction has a latency of three cycles but a throughput of one, so long data is split
+        // into three lanes of this length which are checksummed together and then combined.
+        constexpr size_t Crc32cLaneLength = 1024;
+
+        // Tables which shift a CRC over `Crc32cLaneLength` zero bytes, one per byte of the CRC.  Appending
+        // zeros is linear in the CRC, so the tables hold the shifted value of each byte on its own.
+        struct Crc32cShiftTables {
+            uint32_t tables[4][256];
+
+            Crc32cShiftTables() {
+                uint32_t bits[32];
+                for (size_t bit = 0; bit < 32; ++bit) {
+                    uint32_t crc = uint32_t(1) << bit;
+                    for (size_t i = 0; i < Crc32cLaneLength; ++i) {
+                        crc = (crc >> 8) ^ Crc32cTable[crc & 0xff];
+                    }
+                    bits[bit] = crc;
+                }
+                for (size_t byte = 0; byte < 4; ++byte) {
+                    for (uint32_t value = 0; value < 256; ++value) {
+                        uint32_t shifted = 0;
+                        for (size_t bit = 0; bit < 8; ++bit) {
+                            if (value & (1u << bit)) {
+                                shifted ^= bits[byte * 8 + bit];
+                            }
+                        }
+                        tables[byte][value] = shifted;
+                    }
+                }
+            }
+
+            uint32_t Shift(uint32_t crc) const {
+                return tables[0][crc & 0xff] ^ tables[1][(crc >> 8) & 0xff] ^ tables[2][(crc >> 16) & 0xff] ^ tables[3][crc >> 24];
+            }
+        };
+
+        inline const Crc32cShiftTables& get_crc32c_shift_tables() {
+            static const Crc32cShiftTables tables;
+            return tables;
+        }
+
+        // Updates an inverted CRC32C with the SSE4.2 instruction, eight bytes at a time, in three lanes where
+        // there's enough data.
+        inline uint32_t update_crc32c_sse42(uint32_t crc, const uint8_t* data, size_t length) {
+            size_t i = 0;
+#if defined(__x86_64__) || defined(_M_X64)
+            auto load = [](const uint8_t* p) {
+                uint64_t value = 0;
+                std::memcpy(&value, p, 8);
+                return value;
+            };
+
+            uint64_t crc64 = crc;
+            if (length >= 3 * Crc32cLaneLength) {
+                const Crc32cShiftTables& shift_tables = get_crc32c_shift_tables();
+                for (; i + 3 * Crc32cLaneLength <= length; i += 3 * Crc32cLaneLength) {
+                    const uint8_t* lane = data + i;
+                    uint64_t crc1 = 0;
+                    uint64_t crc2 = 0;
+                    for (size_t j = 0; j < Crc32cLaneLength; j += 8) {
+                        crc64 = _mm_crc32_u64(crc64, load(lane + j));
+                        crc1 = _mm_crc32_u64(crc1, load(lane + Crc32cLaneLength + j));
+                        crc2 = _mm_crc32_u64(crc2, load(lane + 2 * Crc32cLaneLength + j));
+                    }
+                    uint32_t combined = shift_tables.Shift(static_cast<uint32_t>(crc64)) ^ static_cast<uint32_t>(crc1);
+                    crc64 = shift_tables.Shift(combined) ^ static_cast<uint32_t>(crc2);
+                }
+            }
+            for (; i + 8 <= length; i += 8) {
+                crc64 = _mm_crc32_u64(crc64, load(data + i));
+            }
+            crc = static_cast<uint32_t>(crc64);
+#endif
+            for (; i < length; ++i) {
+                crc = _mm_crc32_u8(crc, data[i]);
+            }
+            return crc;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // An incremental CRC32C (Castagnoli), as used by iSCSI, ext4 and many storage and messaging formats.  Uses
+    // the SSE4.2 instruction when available.  Callable with `(const uint8_t* data, size_t length)`, so it can
+    // be passed straight to `encode_checksummed` and `decode_checksummed`.
+    class Crc32c {
+    public:
+        void Update(const uint8_t* data, size_t length) {
+            m_crc = detail::use_sse42_crc32c()
+                ? detail::update_crc32c_sse42(m_crc, data, length)
+                : detail::update_crc32c_basic(m_crc, data, length);
+        }
+
+        void operator()(const uint8_t* data, size_t length) {
+            Update(data, length);
+        }
+
+        // Returns the CRC of all the data so far.
+        uint32_t GetValue() const {
+            return ~m_crc;
+        }
+
+    private:
+        uint32_t m_crc = 0xffffffff;
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes `source_data` into `dest_data` a chunk of 12 KiB at a time, calling `checksum(const uint8_t*
+    // data, size_t length)` with each chunk of the source, in order, straight after encoding it.  The chunk has
+    // just been read, so the checksum reads it from L1 rather than memory.  `checksum` may be a `Crc32c` or any
+    // other incremental hash.  Blocks are prefetched as with `encode_blocks`.  Asserts that the destination
+    // buffer is _exactly_ the required size.
+    template<typename Checksum>
+    inline void encode_checksummed(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        uint8_t* dest_data,
+        const size_t dest_data_length,
+        Checksum&& checksum,
+        const PipelineOptions& options = {}
+    ) {
+        if (get_encoded_length(source_data_length, options.padded) != dest_data_length) {
+            throw std::logic_error("Dest buffer is incorrect size");
+        }
+
+        detail::run_pipeline(
+            source_data,
+            source_data_length,
+            detail::get_pipeline_block_size(options.block_size, 3),
+            detail::EncodeChunkSize,
+            [&](size_t offset, size_t length) {
+                encode(
+                    source_data + offset,
+                    length,
+                    dest_data + (offset / 3) * 4,
+                    get_encoded_length(length, options.padded),
+                    options.padded,
+                    options.codepath
+                );
+                checksum(source_data + offset, length);
+            },
+            [](size_t, size_t) {}
+        );
+    }
+
+    // Decodes `source_data` into `dest_data` a chunk at a time, calling `checksum(const uint8_t* data, size_t
+    // length)` with each chunk of decoded output, in order, straight after decoding it, while it's still in
+    // L1.  Asserts that the destination buffer is _exactly_ the required size.
+    template<typename Checksum>
+    inline void decode_checksummed(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        uint8_t* dest_data,
+        const size_t dest_data_length,
+        Checksum&& checksum,
+        const PipelineOptions& options = {}
+    ) {
+        if (get_decoded_length(source_data, source_data_length) != dest_data_length) {
+            throw std::logic_error("Dest buffer is incorrect size");
+        }
+
+        detail::run_pipeline(
+            source_data,
+            source_data_length,
+            detail::get_pipeline_block_size(options.block_size, 4),
+            detail::DecodeChunkSize,
+            [&](size_t offset, size_t length) {
+                uint8_t* chunk = dest_data + (offset / 4) * 3;
+                size_t chunk_length = get_decoded_length(source_data + offset, length);
+                decode(source_data + offset, length, chunk, chunk_length, options.codepath);
+                checksum(static_cast<const uint8_t*>(chunk), chunk_length);
+            },
+            [](size_t, size_t) {}
+        );
+    }
+
+    // Returns the CRC32C of the source while encoding it.
+    inline uint32_t encode_crc32c(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        uint8_t* dest_data,
+        const size_t dest_data_length,
+        const PipelineOptions& options = {}
+    ) {
+        Crc32c crc;
+        encode_checksummed(source_data, source_data_length, dest_data, dest_data_length, crc, options);
+        return crc.GetValue();
+    }
+
+    // Returns the CRC32C of the decoded output while decoding it.
+    inline uint32_t decode_crc32c(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        uint8_t* dest_data,
+        const size_t dest_data_length,
+        const PipelineOptions& options = {}
+    ) {
+        Crc32c crc;
+        decode_checksummed(source_data, source_data_length, dest_data, dest_data_length, crc, options);
+        return crc.GetValue();
+    }
+
+}
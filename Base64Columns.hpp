@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Base64.hpp"
+#include "Base64Threads.hpp"
+
+// Bulk encoding and decoding of whole binary columns, stored as in Arrow or similar columnar formats: one
+// contiguous data buffer plus an offsets array.
+
+namespace base64 {
+
+    // A column of variable-length values stored back to back: value `i` is `data[offsets[i], offsets[i + 1])`.
+    struct BinaryColumn {
+        std::vector<uint8_t> data;
+        std::vector<uint64_t> offsets = { 0 };
+
+        size_t size() const {
+            return offsets.size() - 1;
+        }
+    };
+
+    struct ColumnOptions {
+        // Whether encoded values are padded.  Ignored when decoding, which accepts either.
+        bool padded = true;
+
+        Codepath codepath = Codepath::Auto;
+
+        // Number of threads to split the rows across.  Zero uses every hardware thread.  No thread is given
+        // fewer than `min_bytes_per_thread` bytes of the column.
+        size_t threads = 1;
+        size_t min_bytes_per_thread = 1024 * 1024;
+    };
+
+    namespace detail {
+        // Transcodes the `count` values of a column into `result`.  The column may be a slice of a larger one,
+        // so `offsets[0]` needn't be zero.  Rows are split between threads so each has an equal share of the
+        // bytes, not of the rows.  Each thread first writes the output lengths of its rows into the result
+        // offsets, which are then summed in one pass, and finally transcodes its rows back to back into place.
+        template<typename GetLength, typename Transcode>
+        inline void transcode_column(
+            const uint8_t* source_data,
+            const uint64_t* source_offsets,
+            size_t count,
+            BinaryColumn& result,
+            const ColumnOptions& options,
+            GetLength&& get_length,
+            Transcode&& transcode
+        ) {
+            uint64_t source_length = source_offsets[count] - source_offsets[0];
+            size_t threads = get_thread_count(options.threads, source_length, options.min_bytes_per_thread);
+
+            std::vector<size_t> first_rows(threads + 1, count);
+            for (size_t index = 0; index < threads; ++index) {
+                uint64_t begin = source_offsets[0] + source_length * index / threads;
+                first_rows[index] = static_cast<size_t>(std::lower_bound(source_offsets, source_offsets + count, begin) - source_offsets);
+            }
+
+            auto get_value = [&](size_t row, size_t& length) {
+                length = static_cast<size_t>(source_offsets[row + 1] - source_offsets[row]);
+                return source_data + source_offsets[row];
+            };
+
+            result.offsets.resize(count + 1);
+            result.offsets[0] = 0;
+            run_threads(threads, [&](size_t index) {
+                for (size_t row = first_rows[index]; row < first_rows[index + 1]; ++row) {
+                    size_t length = 0;
+                    const uint8_t* value = get_value(row, length);
+                    result.offsets[row + 1] = get_length(value, length);
+                }
+            });
+            for (size_t row = 0; row < count; ++row) {
+                result.offsets[row + 1] += result.offsets[row];
+            }
+
+            result.data.clear();
+            result.data.resize(static_cast<size_t>(result.offsets[count]));
+            run_threads(threads, [&](size_t index) {
+                for (size_t row = first_rows[index]; row < first_rows[index + 1]; ++row) {
+                    size_t length = 0;
+                    const uint8_t* value = get_value(row, length);
+                    transcode(
+                        value,
+                        length,
+                        result.data.data() + result.offsets[row],
+                        static_cast<size_t>(result.offsets[row + 1] - result.offsets[row])
+                    );
+                }
+            });
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes each of the `count` values of a column, `source_data[source_offsets[i], source_offsets[i + 1])`,
+    // into `result`, so value `i` of the result is the encoding of value `i` of the source.  All the encoded
+    // lengths are known up front, so the result is allocated once and the values are encoded back to back
+    // straight into it.  Reusing a result across calls keeps its buffers.
+    inline void encode_column(
+        const uint8_t* source_data,
+        const uint64_t* source_offsets,
+        size_t count,
+        BinaryColumn& result,
+        const ColumnOptions& options = {}
+    ) {
+        detail::transcode_column(source_data, source_offsets, count, result, options,
+            [&](const uint8_t*, size_t length) {
+                return get_encoded_length(length, options.padded);
+            },
+            [&](const uint8_t* value, size_t length, uint8_t* dest, size_t dest_length) {
+                encode(value, length, dest, dest_length, options.padded, options.codepath);
+            }
+        );
+    }
+
+    inline BinaryColumn encode_column(const BinaryColumn& source, const ColumnOptions& options = {}) {
+        BinaryColumn result;
+        encode_column(source.data.data(), source.offsets.data(), source.size(), result, options);
+        return result;
+    }
+
+    // Decodes each of the `count` values of a column of base64, padded or not, into `result`.  As with
+    // `decode`, the values are not validated.
+    inline void decode_column(
+        const uint8_t* source_data,
+        const uint64_t* source_offsets,
+        size_t count,
+        BinaryColumn& result,
+        const ColumnOptions& options = {}
+    ) {
+        detail::transcode_column(source_data, source_offsets, count, result, options,
+            [](const uint8_t* value, size_t length) {
+                return get_decoded_length(value, length);
+            },
+            [&](const uint8_t* value, size_t length, uint8_t* dest, size_t dest_length) {
+                decode(value, length, dest, dest_length, options.codepath);
+            }
+        );
+    }
+
+    inline BinaryColumn decode_column(const BinaryColumn& source, const ColumnOptions& options = {}) {
+        BinaryColumn result;
+        decode_column(source.data.data(), source.offsets.data(), source.size(), result, options);
+        return result;
+    }
+
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Base64.hpp"
+
+// Coroutine-based streaming encoding.  Requires C++20 coroutines; otherwise this header is empty.
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace base64 {
+
+    // An asynchronous generator: `co_await generator.next()` resumes the coroutine until it yields a value,
+    // which is returned, or finishes, in which case nothing is returned.  The coroutine may itself await
+    // anything, such as socket reads, in between.
+    template<typename T>
+    class AsyncGenerator {
+    public:
+        struct promise_type;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        struct promise_type {
+            std::optional<T> m_value;
+            std::exception_ptr m_exception;
+            std::coroutine_handle<> m_consumer;
+
+            // Returns control to whoever is awaiting `next`.
+            struct ResumeConsumer {
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(Handle handle) const noexcept {
+                    return handle.promise().m_consumer;
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            AsyncGenerator get_return_object() noexcept {
+                return AsyncGenerator(Handle::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() const noexcept {
+                return {};
+            }
+
+            ResumeConsumer final_suspend() const noexcept {
+                return {};
+            }
+
+            ResumeConsumer yield_value(T value) noexcept {
+                m_value = std::move(value);
+                return {};
+            }
+
+            void return_void() const noexcept {}
+
+            void unhandled_exception() noexcept {
+                m_exception = std::current_exception();
+            }
+        };
+
+        struct NextAwaiter {
+            Handle m_handle;
+
+            bool await_ready() const noexcept {
+                return !m_handle || m_handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept {
+                m_handle.promise().m_consumer = consumer;
+                m_handle.promise().m_value.reset();
+                return m_handle;
+            }
+
+            std::optional<T> await_resume() {
+                if (!m_handle || m_handle.done()) {
+                    if (m_handle && m_handle.promise().m_exception) {
+                        std::rethrow_exception(std::exchange(m_handle.promise().m_exception, nullptr));
+                    }
+                    return std::nullopt;
+                }
+                return std::move(m_handle.promise().m_value);
+            }
+        };
+
+        AsyncGenerator(AsyncGenerator&& other) noexcept
+          : m_handle(std::exchange(other.m_handle, nullptr))
+        {}
+
+        AsyncGenerator& operator=(AsyncGenerator&& other) noexcept {
+            if (this != &other) {
+                if (m_handle) {
+                    m_handle.destroy();
+                }
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        ~AsyncGenerator() {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+        }
+
+        // Resumes the generator until its next value.  Only one `next` may be outstanding at a time.
+        NextAwaiter next() noexcept {
+            return NextAwaiter{ m_handle };
+        }
+
+    private:
+        Handle m_handle;
+
+        explicit AsyncGenerator(Handle handle) noexcept
+          : m_handle(handle)
+        {}
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes the chunks produced by `source`, an asynchronous byte source on which `co_await source.next()`
+    // returns the next chunk as something convertible to std::span<const uint8_t>, with an empty chunk
+    // marking the end of the stream.  A chunk need only remain valid until `source.next()` is awaited again.
+    // Each chunk is encoded as soon as it arrives, up to its last whole group of three bytes; the zero to
+    // two bytes left over are kept in the coroutine frame and prefixed to the next chunk, so every yielded
+    // piece is a whole number of four character groups and is final.  Padding, if any, is only added to
+    // the last piece.
+    //
+    // Yielded spans refer to a buffer owned by the generator and remain valid until `next` is next awaited.
+    // `source` must outlive the generator.
+    template<typename Source>
+    AsyncGenerator<std::span<const uint8_t>> encode_stream(Source& source, bool padded = true, Codepath codepath = Codepath::Auto) {
+        uint8_t carry[3];
+        size_t carry_length = 0;
+        std::vector<uint8_t> output;
+
+        while (true) {
+            std::span<const uint8_t> chunk = co_await source.next();
+            if (chunk.empty()) {
+                break;
+            }
+
+            // Complete the group carried over from the previous chunk.
+            size_t fill = std::min<size_t>(carry_length ? 3 - carry_length : 0, chunk.size());
+            std::copy(chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(fill), carry + carry_length);
+            carry_length += fill;
+            chunk = chunk.subspan(fill);
+            if (carry_length != 0 && carry_length < 3) {
+                continue;
+            }
+
+            size_t whole_length = (chunk.size() / 3) * 3;
+            size_t carry_output = carry_length ? 4 : 0;
+            output.resize(carry_output + get_encoded_length(whole_length));
+
+            if (carry_length != 0) {
+                encode(carry, 3, output.data(), 4, padded, Codepath::Basic);
+                carry_length = 0;
+            }
+            encode(chunk.data(), whole_length, output.data() + carry_output, output.size() - carry_output, padded, codepath);
+
+            carry_length = chunk.size() - whole_length;
+            std::copy(chunk.begin() + static_cast<std::ptrdiff_t>(whole_length), chunk.end(), carry);
+
+            if (!output.empty()) {
+                co_yield std::span<const uint8_t>(output);
+            }
+        }
+
+        if (carry_length != 0) {
+            output.resize(get_encoded_length(carry_length, padded));
+            encode(carry, carry_length, output.data(), output.size(), padded, Codepath::Basic);
+            co_yield std::span<const uint8_t>(output);
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Base64.hpp"
+#include "Base64Threads.hpp"
+
+// Memory-mapped file encoding and decoding.  Requires POSIX.
+
+namespace base64 {
+
+    struct FileOptions {
+        // Padding of the encoded output.  Ignored when decoding.
+        bool padded = true;
+
+        Codepath codepath = Codepath::Auto;
+
+        // Number of threads to split the work across.  Zero uses every hardware thread.  Files are never
+        // split into pieces smaller than `min_bytes_per_thread`.
+        size_t threads = 1;
+        size_t min_bytes_per_thread = 1024 * 1024;
+    };
+
+    namespace detail {
+        [[noreturn]] inline void throw_file_error(const std::string& message, const std::string& path) {
+            throw std::system_error(errno, std::generic_category(), message + " " + path);
+        }
+
+        // An open file descriptor, closed on destruction.
+        class FileDescriptor {
+        public:
+            FileDescriptor(const std::string& path, int flags, mode_t mode = 0)
+              : m_fd(::open(path.c_str(), flags | O_CLOEXEC, mode))
+            {
+                if (m_fd < 0) {
+                    throw_file_error("Unable to open", path);
+                }
+            }
+
+            ~FileDescriptor() {
+                ::close(m_fd);
+            }
+
+            FileDescriptor(const FileDescriptor&) = delete;
+            FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+            int Get() const {
+                return m_fd;
+            }
+
+        private:
+            int m_fd;
+        };
+
+        // A mapping of a whole file, unmapped on destruction.  Empty files are not mapped.
+        class FileMapping {
+        public:
+            FileMapping(const FileDescriptor& file, size_t length, bool writable, const std::string& path)
+              : m_length(length)
+            {
+                if (length == 0) {
+                    return;
+                }
+
+                int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+                void* data = ::mmap(nullptr, length, protection, MAP_SHARED, file.Get(), 0);
+                if (data == MAP_FAILED) {
+                    throw_file_error("Unable to map", path);
+                }
+                m_data = static_cast<uint8_t*>(data);
+            }
+
+            ~FileMapping() {
+                if (m_data) {
+                    ::munmap(m_data, m_length);
+                }
+            }
+
+            FileMapping(const FileMapping&) = delete;
+            FileMapping& operator=(const FileMapping&) = delete;
+
+            uint8_t* Data() const {
+                return m_data;
+            }
+
+        private:
+            uint8_t* m_data = nullptr;
+            size_t m_length;
+        };
+
+        inline size_t get_file_size(const FileDescriptor& file, const std::string& path) {
+            struct stat info;
+            if (::fstat(file.Get(), &info) != 0) {
+                throw_file_error("Unable to read the size of", path);
+            }
+            return static_cast<size_t>(info.st_size);
+        }
+
+        // Throws std::system_error if `dest_file` is the same file as `source_file`, whether through the same
+        // path, a hard link or a symbolic link.  The destination must be opened without `O_TRUNC` and only
+        // resized after this check, as replacing it would destroy the source while it's still being read.
+        inline void check_distinct_files(const FileDescriptor& source_file, const FileDescriptor& dest_file, const std::string& dest_path) {
+            struct stat source_info;
+            struct stat dest_info;
+            if (::fstat(source_file.Get(), &source_info) != 0 || ::fstat(dest_file.Get(), &dest_info) != 0) {
+                throw_file_error("Unable to read the status of", dest_path);
+            }
+            if (source_info.st_dev == dest_info.st_dev && source_info.st_ino == dest_info.st_ino) {
+                throw std::system_error(EINVAL, std::generic_category(), "Source and destination are the same file " + dest_path);
+            }
+        }
+
+        inline void resize_file(const FileDescriptor& file, size_t length, const std::string& path) {
+            if (::ftruncate(file.Get(), static_cast<off_t>(length)) != 0) {
+                throw_file_error("Unable to resize", path);
+            }
+        }
+
+        // Splits [0, length) into one piece per thread, each a whole number of `group_size` groups except
+        // the last, and calls `process(offset, length)` for each piece on its own thread.
+        template<typename Process>
+        inline void run_file_threads(size_t length, size_t group_size, const FileOptions& options, Process&& process) {
+            size_t threads = get_thread_count(options.threads, length, options.min_bytes_per_thread);
+            size_t piece_size = (length / group_size + threads - 1) / threads * group_size;
+            if (threads <= 1 || piece_size == 0) {
+                process(size_t(0), length);
+                return;
+            }
+
+            run_threads((length + piece_size - 1) / piece_size, [&](size_t index) {
+                size_t offset = index * piece_size;
+                process(offset, std::min(piece_size, length - offset));
+            });
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes the file at `source_path` into `dest_path`, which is created or replaced.  Both files are
+    // memory-mapped and encoded directly from one mapping to the other, without intermediate copies.  Throws
+    // std::system_error if either file can't be opened, sized or mapped, or if they're the same file.
+    inline void encode_file(const std::string& source_path, const std::string& dest_path, const FileOptions& options = {}) {
+        detail::FileDescriptor source_file(source_path, O_RDONLY);
+        size_t source_length = detail::get_file_size(source_file, source_path);
+        detail::FileMapping source(source_file, source_length, false, source_path);
+        if (source_length != 0) {
+            ::madvise(source.Data(), source_length, MADV_SEQUENTIAL);
+        }
+
+        size_t dest_length = get_encoded_length(source_length, options.padded);
+        detail::FileDescriptor dest_file(dest_path, O_RDWR | O_CREAT, 0644);
+        detail::check_distinct_files(source_file, dest_file, dest_path);
+        detail::resize_file(dest_file, dest_length, dest_path);
+        detail::FileMapping dest(dest_file, dest_length, true, dest_path);
+
+        detail::run_file_threads(source_length, 3, options, [&](size_t offset, size_t length) {
+            encode(
+                source.Data() + offset,
+                length,
+                dest.Data() + (offset / 3) * 4,
+                get_encoded_length(length, options.padded),
+                options.padded,
+                options.codepath
+            );
+        });
+    }
+
+    // Decodes the base64 file at `source_path` into `dest_path`, which is created or replaced.  Trailing line
+    // breaks are ignored but, as with `decode`, the input is otherwise not validated.  Throws
+    // std::system_error if either file can't be opened, sized or mapped, or if they're the same file.
+    inline void decode_file(const std::string& source_path, const std::string& dest_path, const FileOptions& options = {}) {
+        detail::FileDescriptor source_file(source_path, O_RDONLY);
+        size_t source_length = detail::get_file_size(source_file, source_path);
+        detail::FileMapping source(source_file, source_length, false, source_path);
+        if (source_length != 0) {
+            ::madvise(source.Data(), source_length, MADV_SEQUENTIAL);
+        }
+
+        // Files written by other tools usually end with a line break.
+        while (source_length != 0 && (source.Data()[source_length - 1] == '\n' || source.Data()[source_length - 1] == '\r')) {
+            source_length--;
+        }
+
+        size_t dest_length = get_decoded_length(source.Data(), source_length);
+        detail::FileDescriptor dest_file(dest_path, O_RDWR | O_CREAT, 0644);
+        detail::check_distinct_files(source_file, dest_file, dest_path);
+        detail::resize_file(dest_file, dest_length, dest_path);
+        detail::FileMapping dest(dest_file, dest_length, true, dest_path);
+
+        detail::run_file_threads(source_length, 4, options, [&](size_t offset, size_t length) {
+            decode(
+                source.Data() + offset,
+                length,
+                dest.Data() + (offset / 4) * 3,
+                get_decoded_length(source.Data() + offset, length),
+                options.codepath
+            );
+        });
+    }
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "Base64Wrapped.hpp"
+
+// Parsing of common formats which embed base64: data URIs (RFC 2397) and PEM blocks (RFC 7468).  Parsing
+// only finds the parts of the text, returning views of it, so nothing is copied or allocated; the body is
+// then decoded straight into a caller buffer, or in place, skipping any whitespace.
+
+namespace base64 {
+
+    // A base64 data URI, "data:[<media type>];base64,<data>".
+    struct DataUri {
+        // The media type with any parameters, such as "text/plain;charset=utf-8", or empty if omitted.
+        std::string_view media_type;
+
+        // The encoded data.
+        std::string_view encoded;
+    };
+
+    // A PEM block, "-----BEGIN <label>-----", the encoded data, then "-----END <label>-----".
+    struct PemBlock {
+        std::string_view label;
+
+        // Any RFC 1421 headers, such as "Proc-Type" of legacy encrypted keys, which precede the data and are
+        // separated from it by a blank line.  Empty if there are none.
+        std::string_view headers;
+
+        // The encoded data, including line breaks.
+        std::string_view encoded;
+
+        // The offset in the text just past the end line, where the next block may be searched for.
+        size_t end = 0;
+    };
+
+    namespace detail {
+        inline bool equals_ignoring_case(std::string_view a, std::string_view b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); ++i) {
+                char x = (a[i] >= 'A' && a[i] <= 'Z') ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+                char y = (b[i] >= 'A' && b[i] <= 'Z') ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+                if (x != y) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Returns the offset just past the line break at or after `offset`, or the text length if there's
+        // none.
+        inline size_t skip_line(std::string_view text, size_t offset) {
+            size_t line_end = text.find('\n', offset);
+            return (line_end == std::string_view::npos) ? text.size() : line_end + 1;
+        }
+
+        // Returns true if the line at `offset`, without its line break, is empty or only whitespace.
+        inline bool is_blank_line(std::string_view text, size_t offset) {
+            for (; offset < text.size() && text[offset] != '\n'; ++offset) {
+                if (is_encoded_character(static_cast<uint8_t>(text[offset]))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline const uint8_t* get_bytes(std::string_view text) {
+            return reinterpret_cast<const uint8_t*>(text.data());
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Parses a base64 data URI.  The scheme and the ";base64" marker are matched ignoring case.  Throws
+    // std::invalid_argument if `uri` isn't a data URI or its data isn't base64.  Percent-encoded data isn't
+    // supported.
+    inline DataUri parse_data_uri(std::string_view uri) {
+        constexpr std::string_view Scheme = "data:";
+        constexpr std::string_view Marker = ";base64";
+
+        if (uri.size() < Scheme.size() || !detail::equals_ignoring_case(uri.substr(0, Scheme.size()), Scheme)) {
+            throw std::invalid_argument("Not a data URI");
+        }
+
+        size_t comma = uri.find(',', Scheme.size());
+        if (comma == std::string_view::npos) {
+            throw std::invalid_argument("Data URI has no data");
+        }
+
+        std::string_view metadata = uri.substr(Scheme.size(), comma - Scheme.size());
+        if (metadata.size() < Marker.size() || !detail::equals_ignoring_case(metadata.substr(metadata.size() - Marker.size()), Marker)) {
+            throw std::invalid_argument("Data URI is not base64");
+        }
+
+        DataUri result;
+        result.media_type = metadata.substr(0, metadata.size() - Marker.size());
+        result.encoded = uri.substr(comma + 1);
+        return result;
+    }
+
+    // Parses the first PEM block at or after `offset` in `text`, skipping anything before it, as RFC 7468
+    // allows.  Throws std::invalid_argument if there's no block, or it has no end line with the same label.
+    inline PemBlock parse_pem(std::string_view text, size_t offset = 0) {
+        constexpr std::string_view Begin = "-----BEGIN ";
+        constexpr std::string_view End = "-----END ";
+        constexpr std::string_view Dashes = "-----";
+
+        size_t begin = text.find(Begin, offset);
+        if (begin == std::string_view::npos) {
+            throw std::invalid_argument("No PEM block found");
+        }
+
+        size_t label_begin = begin + Begin.size();
+        size_t label_end = text.find(Dashes, label_begin);
+        size_t line_end = text.find('\n', label_begin);
+        if (label_end == std::string_view::npos || label_end > line_end) {
+            throw std::invalid_argument("Invalid PEM begin line");
+        }
+
+        PemBlock block;
+        block.label = text.substr(label_begin, label_end - label_begin);
+
+        // Headers end at the first blank line, and their first line contains a colon.
+        size_t body = detail::skip_line(text, label_end);
+        size_t first_line_end = text.find('\n', body);
+        std::string_view first_line = text.substr(body, (first_line_end == std::string_view::npos) ? std::string_view::npos : first_line_end - body);
+        if (first_line.find(':') != std::string_view::npos) {
+            size_t headers_begin = body;
+            while (body < text.size() && !detail::is_blank_line(text, body)) {
+                body = detail::skip_line(text, body);
+            }
+            block.headers = text.substr(headers_begin, body - headers_begin);
+            body = detail::skip_line(text, body);
+        }
+
+        size_t end = text.find(End, body);
+        if (end == std::string_view::npos) {
+            throw std::invalid_argument("PEM block has no end line");
+        }
+        size_t end_label_begin = end + End.size();
+        if (text.substr(end_label_begin, block.label.size()) != block.label ||
+            text.substr(end_label_begin + block.label.size(), Dashes.size()) != Dashes) {
+            throw std::invalid_argument("PEM end line does not match begin line");
+        }
+
+        block.encoded = text.substr(body, end - body);
+        block.end = end_label_begin + block.label.size() + Dashes.size();
+        return block;
+    }
+
+    // Parses every PEM block in `text`, such as a certificate chain, in order.
+    inline std::vector<PemBlock> parse_pem_blocks(std::string_view text) {
+        std::vector<PemBlock> blocks;
+        for (size_t offset = 0; text.find("-----BEGIN ", offset) != std::string_view::npos; ) {
+            blocks.push_back(parse_pem(text, offset));
+            offset = blocks.back().end;
+        }
+        return blocks;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Returns the decoded length of the data of a data URI or PEM block.
+    inline size_t get_decoded_length(const DataUri& uri) {
+        return get_wrapped_decoded_length(detail::get_bytes(uri.encoded), uri.encoded.size());
+    }
+
+    inline size_t get_decoded_length(const PemBlock& block) {
+        return get_wrapped_decoded_length(detail::get_bytes(block.encoded), block.encoded.size());
+    }
+
+    // Decodes the data of a data URI or PEM block, skipping whitespace, into `dest_data`, of at least the
+    // decoded length, and returns the decoded length.  `dest_data` may point to the encoded data itself,
+    // within a writable copy of the text, to decode in place.  Throws std::logic_error if the dest buffer is
+    // too small.
+    inline size_t decode(const DataUri& uri, uint8_t* dest_data, size_t dest_data_length, Codepath codepath = Codepath::Auto) {
+        return decode_wrapped(detail::get_bytes(uri.encoded), uri.encoded.size(), dest_data, dest_data_length, codepath);
+    }
+
+    inline size_t decode(const PemBlock& block, uint8_t* dest_data, size_t dest_data_length, Codepath codepath = Codepath::Auto) {
+        return decode_wrapped(detail::get_bytes(block.encoded), block.encoded.size(), dest_data, dest_data_length, codepath);
+    }
+
+}
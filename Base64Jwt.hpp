@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cstring>
+
+#include "Base64Segments.hpp"
+
+// Splitting and decoding of JSON Web Tokens in the JWS compact serialization, "header.payload.signature",
+// whose segments are unpadded base64url (RFC 7515).
+
+namespace base64 {
+
+    // The parts of a decoded token.  `signing_input` is the encoded "header.payload" within the token, over
+    // which the signature is computed; the others refer to the caller's buffers.
+    struct JwtSegments {
+        ConstSegment signing_input;
+        ConstSegment header;
+        ConstSegment payload;
+        ConstSegment signature;
+    };
+
+    // Returns a length of buffer which is always enough for the decoded header and payload, or the decoded
+    // signature, of a token of the given length.
+    constexpr size_t get_jwt_decoded_length_bound(size_t token_length) {
+        return token_length / 4 * 3 + 2;
+    }
+
+    namespace detail {
+        // Finds the two '.' separators of a token.  Returns false if it has fewer; any more are left to
+        // fail validation of the signature.
+        inline bool find_jwt_separators(const uint8_t* token, size_t length, size_t& first, size_t& second) {
+            size_t found = 0;
+            size_t separators[2] = {};
+            size_t i = 0;
+            if (use_avx2()) {
+                const __m256i dot = _mm256_set1_epi8('.');
+                for (; i + 32 <= length && found < 2; i += 32) {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(token + i));
+                    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, dot)));
+                    for (; mask != 0 && found < 2; mask &= mask - 1) {
+#ifdef _MSC_VER
+                        unsigned long bit = 0;
+                        _BitScanForward(&bit, mask);
+#else
+                        unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+                        separators[found++] = i + bit;
+                    }
+                }
+            }
+            for (; i < length && found < 2; ++i) {
+                if (token[i] == '.') {
+                    separators[found++] = i;
+                }
+            }
+
+            first = separators[0];
+            second = separators[1];
+            return found == 2;
+        }
+
+        constexpr bool is_base64url_character(uint8_t c) {
+            return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+        }
+
+        // Checks that `length` characters are base64url and copies them to `dest` translated to the standard
+        // alphabet, for the decoding kernels.  Returns false if any character isn't base64url.
+        inline bool translate_base64url(const uint8_t* source, size_t length, uint8_t* dest) {
+            for (size_t i = 0; i < length; ++i) {
+                uint8_t c = source[i];
+                if (!is_base64url_character(c)) {
+                    return false;
+                }
+                dest[i] = (c == '-') ? '+' : (c == '_') ? '/' : c;
+            }
+            return true;
+        }
+
+        // Validates, translates and decodes 32 base64url characters in one go, storing 24 octets and then
+        // four bytes of garbage at `dest`.  Returns false if any character isn't base64url.
+        inline bool decode_base64url_block_avx2(const uint8_t* source, uint8_t* dest, const DecodeConstantsAVX2& constants) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+            const __m256i minus = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'));
+            const __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+            const __m256i valid = _mm256_or_si256(
+                _mm256_or_si256(in_range_avx2(v, 'A', 'Z'), in_range_avx2(v, 'a', 'z')),
+                _mm256_or_si256(in_range_avx2(v, '0', '9'), _mm256_or_si256(minus, underscore))
+            );
+            if (_mm256_movemask_epi8(valid) != -1) {
+                return false;
+            }
+
+            // '-' becomes '+' and '_' becomes '/'.
+            v = _mm256_blendv_epi8(v, _mm256_set1_epi8('+'), minus);
+            v = _mm256_blendv_epi8(v, _mm256_set1_epi8('/'), underscore);
+
+            const __m256i decoded = decode_block_avx2(v, constants);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm256_extracti128_si256(decoded, 0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 12), _mm256_extracti128_si256(decoded, 1));
+            return true;
+        }
+
+        // Returns the 6-bit value of a base64url character.
+        inline uint8_t get_base64url_value(uint8_t c) {
+            return (c == '-') ? 62 : (c == '_') ? 63 : Base64InverseLUT[c];
+        }
+
+        // Decodes `length` base64url characters into `dest`, which has room for the whole 32 character blocks
+        // covering them plus four bytes, entirely with the vector kernel.  Whole groups past the last whole
+        // block are decoded as a block overlapping the one before, and a final partial group on its own.
+        // Segments shorter than a block are completed with 'A' in a copy.
+        inline bool decode_base64url_avx2(const uint8_t* source, size_t length, uint8_t* dest) {
+            const DecodeConstantsAVX2 constants;
+            if (length < 32) {
+                uint8_t block[32];
+                std::memset(block, 'A', sizeof(block));
+                std::memcpy(block, source, length);
+                return decode_base64url_block_avx2(block, dest, constants);
+            }
+
+            size_t whole_length = length / 4 * 4;
+            size_t i = 0;
+            for (; i + 32 <= whole_length; i += 32) {
+                if (!decode_base64url_block_avx2(source + i, dest + i / 4 * 3, constants)) {
+                    return false;
+                }
+            }
+            if (i < whole_length && !decode_base64url_block_avx2(source + whole_length - 32, dest + (whole_length - 32) / 4 * 3, constants)) {
+                return false;
+            }
+
+            const uint8_t* group = source + whole_length;
+            dest += whole_length / 4 * 3;
+            switch (length - whole_length) {
+            case 3:
+                if (!is_base64url_character(group[2])) {
+                    return false;
+                }
+                dest[1] = static_cast<uint8_t>(get_base64url_value(group[1]) << 4 | get_base64url_value(group[2]) >> 2);
+                [[fallthrough]];
+            case 2:
+                if (!is_base64url_character(group[0]) || !is_base64url_character(group[1])) {
+                    return false;
+                }
+                dest[0] = static_cast<uint8_t>(get_base64url_value(group[0]) << 2 | get_base64url_value(group[1]) >> 4);
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+
+        // Strictly decodes a segment of unpadded base64url into `dest`, of `dest_length` bytes, returning the
+        // decoded length.  The segment is decoded a block at a time into a buffer on the stack: with AVX2 by
+        // validating, translating and decoding each 32 characters in registers, and otherwise by translating
+        // to the standard alphabet and running the regular decoder.
+        inline size_t decode_jwt_segment(const uint8_t* source, size_t length, uint8_t* dest, size_t dest_length, Codepath codepath) {
+            constexpr size_t BlockCharacters = 1024;
+
+            // A single character left over can't encode a byte.
+            if (length % 4 == 1) {
+                throw std::invalid_argument("Invalid JWT segment length");
+            }
+            size_t decoded_length = length / 4 * 3 + ((length % 4) ? length % 4 - 1 : 0);
+            if (decoded_length > dest_length) {
+                throw std::logic_error("Dest buffer is too small");
+            }
+
+            // The bits after the last byte of a partial final group must be zero, so that each sequence of
+            // bytes has exactly one encoding.
+            size_t remainder = length % 4;
+            if (remainder != 0 && is_base64url_character(source[length - 1]) &&
+                (get_base64url_value(source[length - 1]) & ((remainder == 2) ? 0x0f : 0x03)) != 0) {
+                throw std::invalid_argument("Non-canonical JWT segment encoding");
+            }
+
+            bool vectorized = (codepath == Codepath::Auto || codepath == Codepath::AVX2) && use_avx2();
+            for (size_t offset = 0; offset < length; ) {
+                size_t count = std::min(length - offset, BlockCharacters);
+                size_t block_decoded_length = count / 4 * 3 + ((count % 4) ? count % 4 - 1 : 0);
+
+                if (vectorized) {
+                    // The kernel writes a little past the decoded data, so decodes through the stack unless
+                    // the dest has room.
+                    uint8_t decoded[BlockCharacters / 4 * 3 + 4];
+                    bool direct = dest_length >= ((count < 32) ? 28 : count / 4 * 3 + 4);
+                    if (!decode_base64url_avx2(source + offset, count, direct ? dest : decoded)) {
+                        throw std::invalid_argument("Invalid character in JWT segment");
+                    }
+                    if (!direct) {
+                        std::memcpy(dest, decoded, block_decoded_length);
+                    }
+                } else {
+                    uint8_t block[BlockCharacters];
+                    if (!translate_base64url(source + offset, count, block)) {
+                        throw std::invalid_argument("Invalid character in JWT segment");
+                    }
+                    decode(block, count, dest, block_decoded_length, codepath);
+                }
+
+                dest += block_decoded_length;
+                dest_length -= block_decoded_length;
+                offset += count;
+            }
+            return decoded_length;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Splits a compact JWS token and decodes its segments without allocating: the header and payload one
+    // after the other into `claims_data`, and the signature into `signature_data`.  Either buffer is large
+    // enough if it's `get_jwt_decoded_length_bound` of the token length; bytes of either after the decoded
+    // data may be overwritten.  The separators are found with a vectorized scan.  With AVX2 each 32
+    // characters of a segment are then validated, translated to the standard alphabet and decoded in
+    // registers, leaving at most a final partial group to scalar code.
+    //
+    // Validation is strict: the segments must be unpadded base64url, and any unused bits at the end of each
+    // must be zero.  The header must not be empty.  Throws std::invalid_argument if the token is invalid,
+    // and std::logic_error if a buffer is too small.  The JSON of the header and payload isn't checked.
+    inline JwtSegments decode_jwt(
+        const uint8_t* token,
+        size_t token_length,
+        uint8_t* claims_data,
+        size_t claims_data_length,
+        uint8_t* signature_data,
+        size_t signature_data_length,
+        Codepath codepath = Codepath::Auto
+    ) {
+        size_t first = 0;
+        size_t second = 0;
+        if (!detail::find_jwt_separators(token, token_length, first, second)) {
+            throw std::invalid_argument("JWT must have three segments");
+        }
+        if (first == 0) {
+            throw std::invalid_argument("JWT header is empty");
+        }
+
+        JwtSegments segments;
+        segments.signing_input = { token, second };
+
+        size_t header_length = detail::decode_jwt_segment(token, first, claims_data, claims_data_length, codepath);
+        segments.header = { claims_data, header_length };
+
+        size_t payload_length = detail::decode_jwt_segment(
+            token + first + 1,
+            second - first - 1,
+            claims_data + header_length,
+            claims_data_length - header_length,
+            codepath
+        );
+        segments.payload = { claims_data + header_length, payload_length };
+
+        size_t signature_length = detail::decode_jwt_segment(
+            token + second + 1,
+            token_length - second - 1,
+            signature_data,
+            signature_data_length,
+            codepath
+        );
+        segments.signature = { signature_data, signature_length };
+        return segments;
+    }
+
+}
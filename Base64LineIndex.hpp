@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Base64.hpp"
+
+// Random access into line-wrapped base64, such as MIME bodies and PEM files.  Anything at or below a space
+// (line breaks, spaces, tabs) is treated as whitespace; every other byte is an encoded character.
+
+namespace base64 {
+
+    namespace detail {
+        constexpr bool is_encoded_character(uint8_t c) {
+            return c > ' ';
+        }
+
+        inline unsigned count_bits(uint32_t mask) {
+#ifdef _MSC_VER
+            return __popcnt(mask);
+#else
+            return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+        }
+
+        inline unsigned count_trailing_zeros(uint32_t mask) {
+#ifdef _MSC_VER
+            unsigned long index = 0;
+            _BitScanForward(&index, mask);
+            return index;
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        // Returns a mask with a bit set for each encoded character of the 32 bytes at `data`.
+        inline uint32_t get_character_mask_avx2(const uint8_t* data) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            const __m256i whitespace = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(' ')), v);
+            return ~static_cast<uint32_t>(_mm256_movemask_epi8(whitespace));
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Returns the number of encoded characters in `data`.
+        inline size_t count_characters(const uint8_t* data, size_t length) {
+            size_t count = 0;
+            size_t i = 0;
+            if (use_avx2()) {
+                for (; i + 32 <= length; i += 32) {
+                    count += count_bits(get_character_mask_avx2(data + i));
+                }
+            }
+            for (; i < length; ++i) {
+                count += is_encoded_character(data[i]) ? 1 : 0;
+            }
+            return count;
+        }
+
+        // Returns the offset of the encoded character preceded by `skip` others, or `length` if there are
+        // too few.
+        inline size_t skip_characters(const uint8_t* data, size_t length, size_t skip) {
+            size_t i = 0;
+            if (use_avx2()) {
+                for (; i + 32 <= length; i += 32) {
+                    uint32_t mask = get_character_mask_avx2(data + i);
+                    size_t count = count_bits(mask);
+                    if (count > skip) {
+                        // Clear the lowest `skip` bits; the next one is the character wanted.
+                        for (; skip != 0; --skip) {
+                            mask &= mask - 1;
+                        }
+                        return i + count_trailing_zeros(mask);
+                    }
+                    skip -= count;
+                }
+            }
+            for (; i < length; ++i) {
+                if (is_encoded_character(data[i])) {
+                    if (skip == 0) {
+                        return i;
+                    }
+                    skip--;
+                }
+            }
+            return length;
+        }
+
+        // Returns the length of the run of encoded characters at the start of `data`.
+        inline size_t get_character_run(const uint8_t* data, size_t length) {
+            size_t i = 0;
+            if (use_avx2()) {
+                for (; i + 32 <= length; i += 32) {
+                    uint32_t whitespace = ~get_character_mask_avx2(data + i);
+                    if (whitespace != 0) {
+                        return i + count_trailing_zeros(whitespace);
+                    }
+                }
+            }
+            while (i < length && is_encoded_character(data[i])) {
+                i++;
+            }
+            return i;
+        }
+
+        // Copies up to `max_count` encoded characters from `data` to `dest`, a line at a time, skipping
+        // whitespace.  Returns the number of source bytes consumed and sets `count` to the number copied.
+        inline size_t copy_characters(const uint8_t* data, size_t length, uint8_t* dest, size_t max_count, size_t& count) {
+            size_t offset = 0;
+            count = 0;
+            while (count < max_count && offset < length) {
+                while (offset < length && !is_encoded_character(data[offset])) {
+                    offset++;
+                }
+
+                size_t run = get_character_run(data + offset, std::min(length - offset, max_count - count));
+                std::memcpy(dest + count, data + offset, run);
+                offset += run;
+                count += run;
+            }
+            return offset;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // An index of line-wrapped base64 which maps the position of any encoded character, and so any binary
+    // offset, to its position in the file.  It stores the number of encoded characters before every
+    // `sample_interval` bytes of the file, so finding a position scans at most one interval; with the
+    // default of 64 KiB, the index of a 1 GiB file is 128 KiB.  Lines may be any length.
+    //
+    // The index is built incrementally with `Append`, in file order, and can be serialized.  The indexed
+    // data itself isn't kept, so is passed to the lookup and decoding methods, for example from a mapping.
+    class LineIndex {
+    public:
+        static constexpr size_t DefaultSampleInterval = 64 * 1024;
+
+        explicit LineIndex(size_t sample_interval = DefaultSampleInterval)
+          : m_sample_interval(sample_interval)
+        {
+            if (sample_interval == 0) {
+                throw std::invalid_argument("Sample interval must be non-zero");
+            }
+        }
+
+        // Indexes the next `length` bytes of the file.
+        void Append(const uint8_t* data, size_t length) {
+            while (length != 0) {
+                size_t interval_offset = static_cast<size_t>(m_length % m_sample_interval);
+                if (interval_offset == 0) {
+                    m_samples.push_back(m_characters);
+                }
+
+                size_t count = std::min(length, m_sample_interval - interval_offset);
+                m_characters += detail::count_characters(data, count);
+                m_length += count;
+                data += count;
+                length -= count;
+            }
+        }
+
+        // Returns the number of bytes indexed.
+        uint64_t GetLength() const {
+            return m_length;
+        }
+
+        // Returns the number of encoded characters, including padding, in the bytes indexed.
+        uint64_t GetCharacterCount() const {
+            return m_characters;
+        }
+
+        // Returns the offset in the file of encoded character `index`, or the file length if `index` is the
+        // character count.
+        size_t GetFileOffset(const uint8_t* data, uint64_t index) const {
+            if (index > m_characters) {
+                throw std::out_of_range("Character index is past the end of the data");
+            }
+            if (index == m_characters) {
+                return static_cast<size_t>(m_length);
+            }
+
+            size_t sample = static_cast<size_t>(std::upper_bound(m_samples.begin(), m_samples.end(), index) - m_samples.begin()) - 1;
+            size_t offset = sample * m_sample_interval;
+            return offset + detail::skip_characters(data + offset, static_cast<size_t>(m_length) - offset, static_cast<size_t>(index - m_samples[sample]));
+        }
+
+        // Returns the length of the decoded data.
+        size_t GetDecodedLength(const uint8_t* data) const {
+            uint8_t group[4];
+            size_t group_length = ReadFinalGroup(data, group);
+            return static_cast<size_t>((m_characters - group_length) / 4 * 3) + get_decoded_length(group, group_length);
+        }
+
+        // Decodes bytes [offset, offset + length) of the binary data into `dest_data`, reading only the part
+        // of the file covering that range.  Throws std::out_of_range if the range extends past the end of the
+        // decoded data.
+        void DecodeRange(const uint8_t* data, size_t offset, size_t length, uint8_t* dest_data, Codepath codepath = Codepath::Auto) const {
+            // Only ranges reaching into the final group need the padding read to check them.
+            size_t whole_length = static_cast<size_t>((m_characters - detail::get_final_group_length(static_cast<size_t>(m_characters))) / 4 * 3);
+            size_t binary_length = (offset <= whole_length && length <= whole_length - offset) ? whole_length : GetDecodedLength(data);
+            if (offset > binary_length || length > binary_length - offset) {
+                throw std::out_of_range("Range is outside the decoded data");
+            }
+            if (length == 0) {
+                return;
+            }
+
+            // The characters covering the range are gathered into a buffer a block at a time and decoded.
+            constexpr size_t BlockCharacters = 64 * 1024;
+            uint64_t character = (offset / 3) * 4;
+            size_t skip = offset % 3;
+            size_t file_offset = GetFileOffset(data, character);
+            std::vector<uint8_t> block(static_cast<size_t>(std::min<uint64_t>((skip + length + 2) / 3 * 4, BlockCharacters)));
+
+            while (length != 0) {
+                size_t wanted = static_cast<size_t>(std::min<uint64_t>({ (skip + length + 2) / 3 * 4, uint64_t(BlockCharacters), m_characters - character }));
+                size_t count = 0;
+                file_offset += detail::copy_characters(data + file_offset, static_cast<size_t>(m_length) - file_offset, block.data(), wanted, count);
+                if (count != wanted) {
+                    throw std::logic_error("Data does not match the index");
+                }
+
+                size_t decoded = std::min(length, get_decoded_length(block.data(), count) - skip);
+                decode_range(block.data(), count, skip, decoded, dest_data, codepath);
+                dest_data += decoded;
+                length -= decoded;
+                character += count;
+                skip = 0;
+            }
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Serializes the index in a host-endian binary format.
+        std::vector<uint8_t> Serialize() const {
+            std::vector<uint8_t> buffer(sizeof(Magic) + (4 + m_samples.size()) * 8);
+            std::memcpy(buffer.data(), Magic, sizeof(Magic));
+
+            uint8_t* data = buffer.data() + sizeof(Magic);
+            Write(data, m_sample_interval);
+            Write(data, m_length);
+            Write(data, m_characters);
+            Write(data, m_samples.size());
+            for (uint64_t sample : m_samples) {
+                Write(data, sample);
+            }
+            return buffer;
+        }
+
+        // Restores a serialized index, which can then be appended to.  Throws std::invalid_argument if the
+        // data is not a serialized index.
+        static LineIndex Deserialize(const uint8_t* data, size_t length) {
+            if (length < sizeof(Magic) || std::memcmp(data, Magic, sizeof(Magic)) != 0) {
+                throw std::invalid_argument("Not a serialized line index");
+            }
+            const uint8_t* end = data + length;
+            data += sizeof(Magic);
+
+            uint64_t sample_interval = Read(data, end);
+            if (sample_interval == 0) {
+                throw std::invalid_argument("Invalid serialized line index");
+            }
+
+            LineIndex index(static_cast<size_t>(sample_interval));
+            index.m_length = Read(data, end);
+            index.m_characters = Read(data, end);
+            uint64_t sample_count = Read(data, end);
+            if (sample_count != (index.m_length + sample_interval - 1) / sample_interval || static_cast<uint64_t>(end - data) != sample_count * 8) {
+                throw std::invalid_argument("Invalid serialized line index");
+            }
+
+            index.m_samples.resize(static_cast<size_t>(sample_count));
+            for (auto& sample : index.m_samples) {
+                sample = Read(data, end);
+            }
+            return index;
+        }
+
+    private:
+        static constexpr uint8_t Magic[8] = { 'B', '6', '4', 'L', 'I', 'D', 'X', '1' };
+
+        size_t m_sample_interval;
+        uint64_t m_length = 0;
+        uint64_t m_characters = 0;
+
+        // Characters before file offset `i * m_sample_interval`.
+        std::vector<uint64_t> m_samples;
+
+        // Copies the final, possibly padded or partial, group of characters to `group`.
+        size_t ReadFinalGroup(const uint8_t* data, uint8_t* group) const {
+            size_t group_length = detail::get_final_group_length(static_cast<size_t>(m_characters));
+            if (group_length != 0) {
+                size_t offset = GetFileOffset(data, m_characters - group_length);
+                size_t count = 0;
+                detail::copy_characters(data + offset, static_cast<size_t>(m_length) - offset, group, group_length, count);
+            }
+            return group_length;
+        }
+
+        static void Write(uint8_t*& data, uint64_t value) {
+            std::memcpy(data, &value, 8);
+            data += 8;
+        }
+
+        static uint64_t Read(const uint8_t*& data, const uint8_t* end) {
+            if (end - data < 8) {
+                throw std::invalid_argument("Invalid serialized line index");
+            }
+            uint64_t value = 0;
+            std::memcpy(&value, data, 8);
+            data += 8;
+            return value;
+        }
+    };
+
+}
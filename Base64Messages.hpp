@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstring>
+
+#include "Base64Segments.hpp"
+
+// Batched encoding and decoding of many short messages, such as tokens and IDs, which individually are too
+// short to reach the vectorized kernels.
+
+namespace base64 {
+
+    namespace detail {
+        // Messages at least this long are transcoded individually: they make good use of the vectorized
+        // kernels alone, so gathering and scattering them costs more than it saves.
+        constexpr size_t MaxBatchedMessageLength = 64;
+
+        // Binary bytes gathered per batch.  A multiple of three, so the batch encodes to whole groups.
+        constexpr size_t MessageBatchLength = 3 * 1024;
+
+        // Copies `length` bytes, at least `Size`, as two possibly overlapping moves of `Size` bytes.
+        template<size_t Size>
+        inline void copy_overlapping(uint8_t* dest, const uint8_t* source, size_t length) {
+            uint8_t head[Size];
+            uint8_t tail[Size];
+            std::memcpy(head, source, Size);
+            std::memcpy(tail, source + length - Size, Size);
+            std::memcpy(dest, head, Size);
+            std::memcpy(dest + length - Size, tail, Size);
+        }
+
+        // Copies a short message with fixed-size moves, so each doesn't pay for a call to a general `memcpy`.
+        inline void copy_message(uint8_t* dest, const uint8_t* source, size_t length) {
+            if (length > 64) {
+                std::memcpy(dest, source, length);
+            } else if (length >= 32) {
+                copy_overlapping<32>(dest, source, length);
+            } else if (length >= 16) {
+                copy_overlapping<16>(dest, source, length);
+            } else if (length >= 8) {
+                copy_overlapping<8>(dest, source, length);
+            } else if (length >= 4) {
+                copy_overlapping<4>(dest, source, length);
+            } else if (length != 0) {
+                dest[0] = source[0];
+                dest[length / 2] = source[length / 2];
+                dest[length - 1] = source[length - 1];
+            }
+        }
+
+        // Encodes messages together a batch at a time.  Each message is copied into the batch zero-filled to
+        // a whole number of groups, so every group in the batch belongs to exactly one message and one call
+        // to the vectorized kernel encodes them all.  The groups are then copied out to each message's dest,
+        // with the characters after the final partial group replaced by padding or dropped.
+        template<typename SourceSegment, typename DestSegment>
+        inline void encode_messages(
+            const SourceSegment* sources,
+            const DestSegment* dests,
+            size_t count,
+            bool padded,
+            Codepath codepath
+        ) {
+            for (size_t i = 0; i < count; ++i) {
+                if (get_encoded_length(get_segment_length(sources[i]), padded) != get_segment_length(dests[i])) {
+                    throw std::logic_error("Dest buffer is incorrect size");
+                }
+            }
+
+            uint8_t batch[MessageBatchLength];
+            uint8_t encoded[MessageBatchLength / 3 * 4];
+
+            size_t first = 0;
+            while (first < count) {
+                // Gather messages until the batch is full.
+                size_t batch_length = 0;
+                size_t end = first;
+                for (; end < count; ++end) {
+                    size_t length = get_segment_length(sources[end]);
+                    if (length >= MaxBatchedMessageLength) {
+                        if (end == first) {
+                            encode(get_segment_data(sources[end]), length, get_segment_data(dests[end]), get_segment_length(dests[end]), padded, codepath);
+                            first++;
+                            continue;
+                        }
+                        break;
+                    }
+
+                    if (length == 0) {
+                        continue;
+                    }
+                    size_t whole_length = (length + 2) / 3 * 3;
+                    if (batch_length + whole_length > MessageBatchLength) {
+                        break;
+                    }
+                    copy_message(batch + batch_length, get_segment_data(sources[end]), length);
+                    for (size_t j = length; j < whole_length; ++j) {
+                        batch[batch_length + j] = 0;
+                    }
+                    batch_length += whole_length;
+                }
+
+                if (batch_length != 0) {
+                    encode(batch, batch_length, encoded, batch_length / 3 * 4, true, codepath);
+                }
+
+                // Scatter each message's groups to its dest.
+                const uint8_t* group = encoded;
+                for (size_t i = first; i < end; ++i) {
+                    size_t length = get_segment_length(sources[i]);
+                    if (length == 0) {
+                        continue;
+                    }
+                    uint8_t* dest = get_segment_data(dests[i]);
+                    size_t dest_length = get_segment_length(dests[i]);
+                    size_t significant = get_encoded_length(length, false);
+
+                    copy_message(dest, group, significant);
+                    for (size_t j = significant; j < dest_length; ++j) {
+                        dest[j] = '=';
+                    }
+                    group += (length + 2) / 3 * 4;
+                }
+                first = end;
+            }
+        }
+
+        // Decodes messages together a batch at a time, as `encode_messages` does.  Each message is copied into
+        // the batch with its final group completed, so padding and missing characters become 'A', and
+        // every group decodes to three bytes of which only the message's own are copied out.
+        template<typename SourceSegment, typename DestSegment>
+        inline void decode_messages(
+            const SourceSegment* sources,
+            const DestSegment* dests,
+            size_t count,
+            Codepath codepath
+        ) {
+            for (size_t i = 0; i < count; ++i) {
+                if (get_decoded_length(get_segment_data(sources[i]), get_segment_length(sources[i])) != get_segment_length(dests[i])) {
+                    throw std::logic_error("Dest buffer is incorrect size");
+                }
+            }
+
+            uint8_t batch[MessageBatchLength / 3 * 4];
+            uint8_t decoded[MessageBatchLength];
+
+            size_t first = 0;
+            while (first < count) {
+                size_t batch_length = 0;
+                size_t end = first;
+                for (; end < count; ++end) {
+                    size_t length = get_segment_length(sources[end]);
+                    if (length >= MaxBatchedMessageLength) {
+                        if (end == first) {
+                            decode(get_segment_data(sources[end]), length, get_segment_data(dests[end]), get_segment_length(dests[end]), codepath);
+                            first++;
+                            continue;
+                        }
+                        break;
+                    }
+
+                    if (length == 0) {
+                        continue;
+                    }
+                    size_t whole_length = (length + 3) / 4 * 4;
+                    if (batch_length + whole_length > sizeof(batch)) {
+                        break;
+                    }
+                    uint8_t* group = batch + batch_length;
+                    copy_message(group, get_segment_data(sources[end]), length);
+                    for (size_t j = (length == whole_length) ? length - 2 : length; j < whole_length; ++j) {
+                        if (j >= length || group[j] == '=') {
+                            group[j] = 'A';
+                        }
+                    }
+                    batch_length += whole_length;
+                }
+
+                if (batch_length != 0) {
+                    decode(batch, batch_length, decoded, batch_length / 4 * 3, codepath);
+                }
+
+                const uint8_t* group = decoded;
+                for (size_t i = first; i < end; ++i) {
+                    copy_message(get_segment_data(dests[i]), group, get_segment_length(dests[i]));
+                    group += (get_segment_length(sources[i]) + 3) / 4 * 3;
+                }
+                first = end;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes each of `count` messages into its own dest, which must be _exactly_ the encoded length.  Short
+    // messages are packed together group by group and encoded with a single call to the vectorized kernels,
+    // rather than each falling back to the scalar codepath; longer ones are encoded individually.  Sources
+    // and dests may be `ConstSegment`, `Segment` or, on POSIX systems, `iovec`.
+    template<
+        typename SourceSegment,
+        typename DestSegment,
+        typename = std::enable_if_t<detail::is_segment<SourceSegment>::value && detail::is_segment<DestSegment>::value>
+    >
+    inline void encode_messages(
+        const SourceSegment* sources,
+        const DestSegment* dests,
+        size_t count,
+        bool padded = true,
+        Codepath codepath = Codepath::Auto
+    ) {
+        detail::encode_messages(sources, dests, count, padded, codepath);
+    }
+
+    // Decodes each of `count` messages, padded or not, into its own dest, which must be _exactly_ the
+    // decoded length.  As with `decode`, the messages are not validated.
+    template<
+        typename SourceSegment,
+        typename DestSegment,
+        typename = std::enable_if_t<detail::is_segment<SourceSegment>::value && detail::is_segment<DestSegment>::value>
+    >
+    inline void decode_messages(
+        const SourceSegment* sources,
+        const DestSegment* dests,
+        size_t count,
+        Codepath codepath = Codepath::Auto
+    ) {
+        detail::decode_messages(sources, dests, count, codepath);
+    }
+
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "Base64.hpp"
+
+namespace base64 {
+
+    struct PipelineOptions {
+        // Source bytes per block.  Each block, its output and the prefetched next block should fit in L2
+        // together, which the default does even on CPUs with a 256 KiB L2.  Rounded down to whole groups.
+        size_t block_size = 64 * 1024;
+
+        // Padding of the final block when encoding.  Ignored when decoding.
+        bool padded = true;
+
+        Codepath codepath = Codepath::Auto;
+    };
+
+    namespace detail {
+        // Source bytes processed between prefetches.  Multiples of both the encoding and decoding group
+        // sizes, so that only the final chunk can end part way through a group.
+        constexpr size_t EncodeChunkSize = 3 * 4096;
+        constexpr size_t DecodeChunkSize = 4 * 4096;
+
+        constexpr size_t CacheLineSize = 64;
+
+        inline void prefetch_l2(const uint8_t* begin, const uint8_t* end) {
+            for (auto ptr = begin; ptr < end; ptr += CacheLineSize) {
+                _mm_prefetch(reinterpret_cast<const char*>(ptr), _MM_HINT_T1);
+            }
+        }
+
+        // Splits [0, length) into blocks of `block_size` and each block into chunks of `chunk_size`.  Before
+        // `process_chunk(offset, length)` runs on a chunk, the matching chunk of the next block is prefetched
+        // into L2, so that the next block is already cached when it starts.  `finish_block(offset, length)`
+        // runs once all of a block's chunks have been processed.
+        template<typename ProcessChunk, typename FinishBlock>
+        inline void run_pipeline(
+            const uint8_t* source_data,
+            const size_t source_data_length,
+            const size_t block_size,
+            const size_t chunk_size,
+            ProcessChunk&& process_chunk,
+            FinishBlock&& finish_block
+        ) {
+            for (size_t block = 0; block < source_data_length; block += block_size) {
+                size_t block_end = std::min(source_data_length, block + block_size);
+                size_t next_block_end = std::min(source_data_length, block_end + block_size);
+
+                for (size_t chunk = block; chunk < block_end; chunk += chunk_size) {
+                    size_t chunk_end = std::min(block_end, chunk + chunk_size);
+
+                    size_t ahead = chunk + block_size;
+                    if (ahead < next_block_end) {
+                        size_t ahead_end = std::min(next_block_end, chunk_end + block_size);
+                        prefetch_l2(source_data + ahead, source_data + ahead_end);
+                    }
+
+                    process_chunk(chunk, chunk_end - chunk);
+                }
+
+                finish_block(block, block_end - block);
+            }
+        }
+
+        inline size_t get_pipeline_block_size(size_t block_size, size_t group_size) {
+            return std::max(block_size / group_size, size_t(1)) * group_size;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes a large buffer one cache-sized block at a time into `dest_data`, prefetching the next block's
+    // source while the current one is encoded.  After each block, `consume(const uint8_t* data, size_t
+    // length)` is called with that block's output while it's still in cache, so that a following step such
+    // as hashing or writing doesn't read it back from memory.  Asserts that the destination buffer is
+    // _exactly_ the required size.
+    template<typename Consumer>
+    inline void encode_blocks(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        uint8_t* dest_data,
+        const size_t dest_data_length,
+        Consumer&& consume,
+        const PipelineOptions& options = {}
+    ) {
+        if (get_encoded_length(source_data_length, options.padded) != dest_data_length) {
+            throw std::logic_error("Dest buffer is incorrect size");
+        }
+
+        detail::run_pipeline(
+            source_data,
+            source_data_length,
+            detail::get_pipeline_block_size(options.block_size, 3),
+            detail::EncodeChunkSize,
+            [&](size_t offset, size_t length) {
+                encode(
+                    source_data + offset,
+                    length,
+                    dest_data + (offset / 3) * 4,
+                    get_encoded_length(length, options.padded),
+                    options.padded,
+                    options.codepath
+                );
+            },
+            [&](size_t offset, size_t length) {
+                consume(
+                    static_cast<const uint8_t*>(dest_data + (offset / 3) * 4),
+                    get_encoded_length(length, options.padded)
+                );
+            }
+        );
+    }
+
+    // As above, but without keeping the output.  Each block is encoded into the same block-sized buffer, so
+    // the output never leaves the cache and `consume` must copy anything it wants to keep.
+    template<typename Consumer>
+    inline void encode_blocks(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        Consumer&& consume,
+        const PipelineOptions& options = {}
+    ) {
+        size_t block_size = detail::get_pipeline_block_size(options.block_size, 3);
+        std::vector<uint8_t> block_buffer(get_encoded_length(std::min(block_size, source_data_length)));
+
+        detail::run_pipeline(
+            source_data,
+            source_data_length,
+            block_size,
+            detail::EncodeChunkSize,
+            [&](size_t offset, size_t length) {
+                size_t block_offset = offset % block_size;
+                encode(
+                    source_data + offset,
+                    length,
+                    block_buffer.data() + (block_offset / 3) * 4,
+                    get_encoded_length(length, options.padded),
+                    options.padded,
+                    options.codepath
+                );
+            },
+            [&](size_t, size_t length) {
+                consume(static_cast<const uint8_t*>(block_buffer.data()), get_encoded_length(length, options.padded));
+            }
+        );
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Decodes a large buffer one cache-sized block at a time into `dest_data`, calling `consume(const
+    // uint8_t* data, size_t length)` with each block's output while it's still in cache.  Asserts that the
+    // destination buffer is _exactly_ the required size.
+    template<typename Consumer>
+    inline void decode_blocks(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        uint8_t* dest_data,
+        const size_t dest_data_length,
+        Consumer&& consume,
+        const PipelineOptions& options = {}
+    ) {
+        if (get_decoded_length(source_data, source_data_length) != dest_data_length) {
+            throw std::logic_error("Dest buffer is incorrect size");
+        }
+
+        detail::run_pipeline(
+            source_data,
+            source_data_length,
+            detail::get_pipeline_block_size(options.block_size, 4),
+            detail::DecodeChunkSize,
+            [&](size_t offset, size_t length) {
+                decode(
+                    source_data + offset,
+                    length,
+                    dest_data + (offset / 4) * 3,
+                    get_decoded_length(source_data + offset, length),
+                    options.codepath
+                );
+            },
+            [&](size_t offset, size_t length) {
+                consume(
+                    static_cast<const uint8_t*>(dest_data + (offset / 4) * 3),
+                    get_decoded_length(source_data + offset, length)
+                );
+            }
+        );
+    }
+
+    // As above, but without keeping the output.  Each block is decoded into the same block-sized buffer, so
+    // `consume` must copy anything it wants to keep.
+    template<typename Consumer>
+    inline void decode_blocks(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        Consumer&& consume,
+        const PipelineOptions& options = {}
+    ) {
+        size_t block_size = detail::get_pipeline_block_size(options.block_size, 4);
+        std::vector<uint8_t> block_buffer((std::min(block_size, source_data_length) / 4 + 1) * 3);
+
+        detail::run_pipeline(
+            source_data,
+            source_data_length,
+            block_size,
+            detail::DecodeChunkSize,
+            [&](size_t offset, size_t length) {
+                size_t block_offset = offset % block_size;
+                decode(
+                    source_data + offset,
+                    length,
+                    block_buffer.data() + (block_offset / 4) * 3,
+                    get_decoded_length(source_data + offset, length),
+                    options.codepath
+                );
+            },
+            [&](size_t offset, size_t length) {
+                consume(static_cast<const uint8_t*>(block_buffer.data()), get_decoded_length(source_data + offset, length));
+            }
+        );
+    }
+
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Base64.hpp"
+#include "Base64Threads.hpp"
+
+// Batch decoding of newline-delimited records, one base64 value per line, into a columnar layout.
+
+namespace base64 {
+
+    // Decoded records stored back to back, as in an Arrow binary column: record `i` is
+    // `data[offsets[i], offsets[i + 1])`.
+    struct RecordBatch {
+        std::vector<uint8_t> data;
+        std::vector<uint64_t> offsets = { 0 };
+
+        // Indices of records which failed validation and were left empty, when skipping invalid records.
+        std::vector<size_t> invalid_records;
+
+        size_t size() const {
+            return offsets.size() - 1;
+        }
+    };
+
+    struct RecordBatchOptions {
+        // Leave invalid records empty and list them in `invalid_records`, rather than throwing.
+        bool skip_invalid = false;
+
+        Codepath codepath = Codepath::Auto;
+
+        // Number of threads to split the work across.  Zero uses every hardware thread.  Input is never
+        // split into pieces smaller than `min_bytes_per_thread`.
+        size_t threads = 1;
+        size_t min_bytes_per_thread = 1024 * 1024;
+    };
+
+    namespace detail {
+        // Calls `process(index, begin, end)` for each of `count` even splits of [0, length), each on its own
+        // thread.
+        template<typename Process>
+        inline void run_record_threads(size_t count, size_t length, Process&& process) {
+            auto get_begin = [&](size_t index) {
+                return static_cast<size_t>(static_cast<unsigned long long>(length) * index / count);
+            };
+
+            run_threads(count, [&](size_t index) {
+                process(index, get_begin(index), get_begin(index + 1));
+            });
+        }
+
+        // Returns the record ending at `line_end`, without any '\r', and sets `length`.
+        inline const uint8_t* get_record(const uint8_t* data, size_t begin, size_t line_end, size_t& length) {
+            length = line_end - begin;
+            if (length != 0 && data[line_end - 1] == '\r') {
+                length--;
+            }
+            return data + begin;
+        }
+
+        // The line ends of a piece of the input, with the decoded length of each line's record.  The first
+        // record starts in an earlier piece, so its length is filled in once the pieces are joined.
+        struct LineScan {
+            std::vector<size_t> line_ends;
+            std::vector<uint64_t> decoded_lengths;
+        };
+
+        // Finds every '\n' in [begin, end) of `data`.  Each record's decoded length is found as its line end
+        // is, while the end of the record is still in cache.
+        inline void scan_lines(const uint8_t* data, size_t begin, size_t end, LineScan& scan) {
+            auto add_line_end = [&](size_t line_end) {
+                uint64_t decoded_length = 0;
+                if (!scan.line_ends.empty()) {
+                    size_t length = 0;
+                    const uint8_t* record = get_record(data, scan.line_ends.back() + 1, line_end, length);
+                    decoded_length = get_decoded_length(record, length);
+                }
+                scan.line_ends.push_back(line_end);
+                scan.decoded_lengths.push_back(decoded_length);
+            };
+
+            size_t i = begin;
+            if (use_avx2()) {
+                const __m256i newline = _mm256_set1_epi8('\n');
+                for (; i + 32 <= end; i += 32) {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)));
+                    while (mask != 0) {
+#ifdef _MSC_VER
+                        unsigned long bit = 0;
+                        _BitScanForward(&bit, mask);
+#else
+                        unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+                        add_line_end(i + bit);
+                        mask &= mask - 1;
+                    }
+                }
+            }
+            for (; i < end; ++i) {
+                if (data[i] == '\n') {
+                    add_line_end(i);
+                }
+            }
+        }
+
+        // Returns true if all of `data` is in the base64 alphabet.
+        inline bool is_alphabet(const uint8_t* data, size_t length) {
+            size_t i = 0;
+            if (use_avx2()) {
+                auto is_block_valid = [&](const uint8_t* block) {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+                    __m256i valid = _mm256_or_si256(
+                        _mm256_or_si256(in_range_avx2(v, 'A', 'Z'), in_range_avx2(v, 'a', 'z')),
+                        _mm256_or_si256(in_range_avx2(v, '/', '9'), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')))
+                    );
+                    return _mm256_movemask_epi8(valid) == -1;
+                };
+
+                if (length >= 32) {
+                    for (; i + 32 <= length; i += 32) {
+                        if (!is_block_valid(data + i)) {
+                            return false;
+                        }
+                    }
+                    // The last block overlaps the one before rather than finishing one byte at a time.
+                    return i == length || is_block_valid(data + length - 32);
+                }
+            }
+            for (; i < length; ++i) {
+                uint8_t c = data[i];
+                bool valid = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '/' && c <= '9') || c == '+';
+                if (!valid) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Returns true if `data` is a complete base64 value: alphabet characters, optionally followed by the
+        // padding needed to make whole groups.
+        inline bool is_valid_record(const uint8_t* data, size_t length) {
+            if (length % 4 == 1) {
+                return false;
+            }
+
+            size_t padding = 0;
+            if (length % 4 == 0 && length != 0 && data[length - 1] == '=') {
+                padding = (data[length - 2] == '=') ? 2 : 1;
+            }
+            return is_alphabet(data, length - padding);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Decodes newline-delimited base64 records, which may end with "\r\n", into a single `RecordBatch`
+    // without allocating anything per record.  Line ends are found with a vectorized scan; each record is
+    // validated and its decoded length summed into the offsets, then every record is decoded straight into
+    // place in the shared data.  Empty lines are empty records and a final line break doesn't start another.
+    // Throws std::invalid_argument for the first invalid record unless `skip_invalid` is set.
+    // Reusing a batch across calls keeps its buffers, so each call doesn't have to fault in new memory.
+    inline void decode_records(const uint8_t* source_data, size_t source_data_length, RecordBatch& batch, const RecordBatchOptions& options = {}) {
+        size_t threads = detail::get_thread_count(options.threads, source_data_length, options.min_bytes_per_thread);
+
+        // Find the line ends and decoded lengths in each piece.
+        std::vector<detail::LineScan> scans(threads);
+        detail::run_record_threads(threads, source_data_length, [&](size_t index, size_t begin, size_t end) {
+            detail::scan_lines(source_data, begin, end, scans[index]);
+        });
+
+        // Join the pieces, completing the records which span them, and sum the decoded lengths into offsets.
+        batch.offsets.assign(1, 0);
+        batch.invalid_records.clear();
+        std::vector<size_t> line_ends = std::move(scans[0].line_ends);
+        batch.offsets.insert(batch.offsets.end(), scans[0].decoded_lengths.begin(), scans[0].decoded_lengths.end());
+        std::vector<size_t> piece_first_records = { 0 };
+        for (size_t index = 1; index < threads; ++index) {
+            piece_first_records.push_back(line_ends.size());
+            line_ends.insert(line_ends.end(), scans[index].line_ends.begin(), scans[index].line_ends.end());
+            batch.offsets.insert(batch.offsets.end(), scans[index].decoded_lengths.begin(), scans[index].decoded_lengths.end());
+        }
+        if (source_data_length != 0 && source_data[source_data_length - 1] != '\n') {
+            piece_first_records.push_back(line_ends.size());
+            line_ends.push_back(source_data_length);
+            batch.offsets.push_back(0);
+        }
+
+        size_t record_count = line_ends.size();
+        auto get_record = [&](size_t record, size_t& length) {
+            return detail::get_record(source_data, record ? line_ends[record - 1] + 1 : 0, line_ends[record], length);
+        };
+
+        for (size_t record : piece_first_records) {
+            if (record < record_count) {
+                size_t length = 0;
+                const uint8_t* data = get_record(record, length);
+                batch.offsets[record + 1] = get_decoded_length(data, length);
+            }
+        }
+        for (size_t record = 0; record < record_count; ++record) {
+            batch.offsets[record + 1] += batch.offsets[record];
+        }
+
+        // Validate and decode each record in one pass, while it's in cache.
+        batch.data.clear();
+        batch.data.resize(static_cast<size_t>(batch.offsets[record_count]));
+        std::vector<uint8_t> valid(record_count);
+        detail::run_record_threads(threads, record_count, [&](size_t, size_t begin, size_t end) {
+            for (size_t record = begin; record < end; ++record) {
+                size_t length = 0;
+                const uint8_t* data = get_record(record, length);
+                valid[record] = detail::is_valid_record(data, length);
+                if (valid[record]) {
+                    decode(
+                        data,
+                        length,
+                        batch.data.data() + batch.offsets[record],
+                        static_cast<size_t>(batch.offsets[record + 1] - batch.offsets[record]),
+                        options.codepath
+                    );
+                }
+            }
+        });
+
+        // Invalid records are rare, so are removed from the data afterwards.
+        size_t first_invalid = static_cast<size_t>(std::find(valid.begin(), valid.end(), uint8_t(0)) - valid.begin());
+        if (first_invalid != record_count) {
+            if (!options.skip_invalid) {
+                throw std::invalid_argument("Invalid base64 record on line " + std::to_string(first_invalid + 1));
+            }
+
+            uint64_t read = batch.offsets[first_invalid];
+            uint64_t write = read;
+            for (size_t record = first_invalid; record < record_count; ++record) {
+                uint64_t end = batch.offsets[record + 1];
+                if (valid[record]) {
+                    std::memmove(batch.data.data() + write, batch.data.data() + read, static_cast<size_t>(end - read));
+                    write += end - read;
+                } else {
+                    batch.invalid_records.push_back(record);
+                }
+                batch.offsets[record + 1] = write;
+                read = end;
+            }
+            batch.data.resize(static_cast<size_t>(write));
+        }
+    }
+
+    inline RecordBatch decode_records(const uint8_t* source_data, size_t source_data_length, const RecordBatchOptions& options = {}) {
+        RecordBatch batch;
+        decode_records(source_data, source_data_length, batch, options);
+        return batch;
+    }
+
+}
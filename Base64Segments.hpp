@@ -0,0 +1,318 @@
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "Base64.hpp"
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#define BASE64_HAS_IOVEC
+#endif
+
+// Scatter-gather encoding and decoding, between lists of non-contiguous segments.
+
+namespace base64 {
+
+    // A read-only piece of a larger message.
+    struct ConstSegment {
+        const uint8_t* data;
+        size_t length;
+    };
+
+    // A writable piece of a larger buffer.
+    struct Segment {
+        uint8_t* data;
+        size_t length;
+    };
+
+    namespace detail {
+        inline const uint8_t* get_segment_data(const ConstSegment& segment) { return segment.data; }
+        inline size_t get_segment_length(const ConstSegment& segment) { return segment.length; }
+
+        inline uint8_t* get_segment_data(const Segment& segment) { return segment.data; }
+        inline size_t get_segment_length(const Segment& segment) { return segment.length; }
+
+#ifdef BASE64_HAS_IOVEC
+        inline uint8_t* get_segment_data(const iovec& segment) { return static_cast<uint8_t*>(segment.iov_base); }
+        inline size_t get_segment_length(const iovec& segment) { return segment.iov_len; }
+#endif
+
+        template<typename T, typename = void>
+        struct is_segment : std::false_type {};
+
+        template<typename T>
+        struct is_segment<T, std::void_t<decltype(get_segment_length(std::declval<const T&>()))>> : std::true_type {};
+
+        template<typename SegmentType>
+        inline size_t get_total_length(const SegmentType* segments, size_t count) {
+            size_t length = 0;
+            for (size_t i = 0; i < count; ++i) {
+                length += get_segment_length(segments[i]);
+            }
+            return length;
+        }
+
+        // Copies the last `length` bytes of a list of segments to `dest`.
+        template<typename SegmentType>
+        inline void copy_segment_tail(const SegmentType* segments, size_t count, uint8_t* dest, size_t length) {
+            for (size_t i = count; i-- > 0 && length != 0; ) {
+                size_t n = std::min(length, get_segment_length(segments[i]));
+                length -= n;
+                std::memcpy(dest + length, get_segment_data(segments[i]) + get_segment_length(segments[i]) - n, n);
+            }
+        }
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Fills a list of segments in order.  Output is either written directly into the space of the current
+        // segment, using `Reserve` and `Commit`, or copied with `Write`, which spans segment boundaries.
+        template<typename SegmentType>
+        class SegmentWriter {
+        public:
+            SegmentWriter(const SegmentType* segments, size_t count)
+              : m_segments(segments)
+              , m_count(count)
+            {}
+
+            // Returns the free space of the current segment, moving past any that are full.
+            uint8_t* Reserve(size_t& space) {
+                while (m_index < m_count && m_offset == get_segment_length(m_segments[m_index])) {
+                    m_index++;
+                    m_offset = 0;
+                }
+                if (m_index == m_count) {
+                    space = 0;
+                    return nullptr;
+                }
+                space = get_segment_length(m_segments[m_index]) - m_offset;
+                return get_segment_data(m_segments[m_index]) + m_offset;
+            }
+
+            void Commit(size_t length) {
+                m_offset += length;
+            }
+
+            void Write(const uint8_t* data, size_t length) {
+                while (length != 0) {
+                    size_t space = 0;
+                    uint8_t* dest = Reserve(space);
+                    size_t n = std::min(space, length);
+                    std::memcpy(dest, data, n);
+                    Commit(n);
+                    data += n;
+                    length -= n;
+                }
+            }
+
+        private:
+            const SegmentType* m_segments;
+            size_t m_count;
+            size_t m_index = 0;
+            size_t m_offset = 0;
+        };
+
+        //----------------------------------------------------------------------------------------------------
+
+        template<typename SourceSegment, typename DestSegment>
+        inline void encode_segments(
+            const SourceSegment* source_segments,
+            size_t source_segment_count,
+            const DestSegment* dest_segments,
+            size_t dest_segment_count,
+            bool padded,
+            Codepath codepath
+        ) {
+            size_t source_length = get_total_length(source_segments, source_segment_count);
+            if (get_encoded_length(source_length, padded) != get_total_length(dest_segments, dest_segment_count)) {
+                throw std::logic_error("Dest buffer is incorrect size");
+            }
+
+            SegmentWriter<DestSegment> writer(dest_segments, dest_segment_count);
+            uint8_t carry[3];
+            size_t carry_length = 0;
+            uint8_t group[4];
+
+            for (size_t index = 0; index < source_segment_count; ++index) {
+                const uint8_t* data = get_segment_data(source_segments[index]);
+                size_t length = get_segment_length(source_segments[index]);
+
+                // Complete the group left over from the previous segments.
+                if (carry_length != 0) {
+                    size_t fill = std::min(3 - carry_length, length);
+                    std::memcpy(carry + carry_length, data, fill);
+                    carry_length += fill;
+                    data += fill;
+                    length -= fill;
+                    if (carry_length < 3) {
+                        continue;
+                    }
+                    encode(carry, 3, group, 4, true, Codepath::Basic);
+                    writer.Write(group, 4);
+                    carry_length = 0;
+                }
+
+                // Encode whole groups straight into the destination, a destination segment at a time.
+                size_t whole_length = (length / 3) * 3;
+                size_t offset = 0;
+                while (offset < whole_length) {
+                    size_t space = 0;
+                    uint8_t* dest = writer.Reserve(space);
+                    size_t groups = std::min((whole_length - offset) / 3, space / 4);
+                    if (groups == 0) {
+                        // The next group straddles two destination segments.
+                        encode(data + offset, 3, group, 4, true, Codepath::Basic);
+                        writer.Write(group, 4);
+                        offset += 3;
+                        continue;
+                    }
+                    encode(data + offset, groups * 3, dest, groups * 4, true, codepath);
+                    writer.Commit(groups * 4);
+                    offset += groups * 3;
+                }
+
+                carry_length = length - whole_length;
+                std::memcpy(carry, data + whole_length, carry_length);
+            }
+
+            if (carry_length != 0) {
+                size_t group_length = get_encoded_length(carry_length, padded);
+                encode(carry, carry_length, group, group_length, padded, Codepath::Basic);
+                writer.Write(group, group_length);
+            }
+        }
+
+        template<typename SourceSegment, typename DestSegment>
+        inline void decode_segments(
+            const SourceSegment* source_segments,
+            size_t source_segment_count,
+            const DestSegment* dest_segments,
+            size_t dest_segment_count,
+            Codepath codepath
+        ) {
+            // Only the final group may be padded or partial, so it's decoded separately and everything before
+            // it is whole groups.
+            size_t source_length = get_total_length(source_segments, source_segment_count);
+            size_t tail_length = get_final_group_length(source_length);
+            uint8_t tail[4];
+            copy_segment_tail(source_segments, source_segment_count, tail, tail_length);
+
+            size_t body_length = source_length - tail_length;
+            size_t tail_decoded_length = get_decoded_length(tail, tail_length);
+            if ((body_length / 4) * 3 + tail_decoded_length != get_total_length(dest_segments, dest_segment_count)) {
+                throw std::logic_error("Dest buffer is incorrect size");
+            }
+
+            SegmentWriter<DestSegment> writer(dest_segments, dest_segment_count);
+            uint8_t carry[4];
+            size_t carry_length = 0;
+            uint8_t group[3];
+
+            for (size_t index = 0; index < source_segment_count && body_length != 0; ++index) {
+                const uint8_t* data = get_segment_data(source_segments[index]);
+                size_t length = std::min(get_segment_length(source_segments[index]), body_length);
+                body_length -= length;
+
+                // Complete the group left over from the previous segments.
+                if (carry_length != 0) {
+                    size_t fill = std::min(4 - carry_length, length);
+                    std::memcpy(carry + carry_length, data, fill);
+                    carry_length += fill;
+                    data += fill;
+                    length -= fill;
+                    if (carry_length < 4) {
+                        continue;
+                    }
+                    decode(carry, 4, group, 3, Codepath::Basic);
+                    writer.Write(group, 3);
+                    carry_length = 0;
+                }
+
+                // Decode whole groups straight into the destination, a destination segment at a time.
+                size_t whole_length = (length / 4) * 4;
+                size_t offset = 0;
+                while (offset < whole_length) {
+                    size_t space = 0;
+                    uint8_t* dest = writer.Reserve(space);
+                    size_t groups = std::min((whole_length - offset) / 4, space / 3);
+                    if (groups == 0) {
+                        // The next group straddles two destination segments.
+                        decode(data + offset, 4, group, 3, Codepath::Basic);
+                        writer.Write(group, 3);
+                        offset += 4;
+                        continue;
+                    }
+                    decode(data + offset, groups * 4, dest, groups * 3, codepath);
+                    writer.Commit(groups * 3);
+                    offset += groups * 4;
+                }
+
+                carry_length = length - whole_length;
+                std::memcpy(carry, data + whole_length, carry_length);
+            }
+
+            if (tail_length != 0) {
+                decode(tail, tail_length, group, tail_decoded_length, Codepath::Basic);
+                writer.Write(group, tail_decoded_length);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Segments may be `ConstSegment` or `Segment` or, on POSIX systems, `iovec`, so that a message assembled
+    // for `readv` can be encoded and the output passed straight to `writev`.
+    template<typename SegmentType, typename = std::enable_if_t<detail::is_segment<SegmentType>::value>>
+    inline size_t get_encoded_length(const SegmentType* segments, size_t segment_count, bool padded = true) {
+        return get_encoded_length(detail::get_total_length(segments, segment_count), padded);
+    }
+
+    template<typename SegmentType, typename = std::enable_if_t<detail::is_segment<SegmentType>::value>>
+    inline size_t get_decoded_length(const SegmentType* segments, size_t segment_count) {
+        size_t length = detail::get_total_length(segments, segment_count);
+        size_t tail_length = detail::get_final_group_length(length);
+        uint8_t tail[4];
+        detail::copy_segment_tail(segments, segment_count, tail, tail_length);
+        return ((length - tail_length) / 4) * 3 + get_decoded_length(tail, tail_length);
+    }
+
+    // Encodes the concatenation of the source segments into the destination segments, which are filled in
+    // order and must total _exactly_ the encoded length.  Groups which span a segment boundary, on either
+    // side, are assembled separately; everything else is encoded in place with the vectorized codepaths.
+    template<
+        typename SourceSegment,
+        typename DestSegment,
+        typename = std::enable_if_t<detail::is_segment<SourceSegment>::value && detail::is_segment<DestSegment>::value>
+    >
+    inline void encode(
+        const SourceSegment* source_segments,
+        size_t source_segment_count,
+        const DestSegment* dest_segments,
+        size_t dest_segment_count,
+        bool padded = true,
+        Codepath codepath = Codepath::Auto
+    ) {
+        detail::encode_segments(source_segments, source_segment_count, dest_segments, dest_segment_count, padded, codepath);
+    }
+
+    // Decodes the concatenation of the source segments into the destination segments, which are filled in
+    // order and must total _exactly_ the decoded length.
+    template<
+        typename SourceSegment,
+        typename DestSegment,
+        typename = std::enable_if_t<detail::is_segment<SourceSegment>::value && detail::is_segment<DestSegment>::value>
+    >
+    inline void decode(
+        const SourceSegment* source_segments,
+        size_t source_segment_count,
+        const DestSegment* dest_segments,
+        size_t dest_segment_count,
+        Codepath codepath = Codepath::Auto
+    ) {
+        detail::decode_segments(source_segments, source_segment_count, dest_segments, dest_segment_count, codepath);
+    }
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Splitting of work across threads, shared by the multi-threaded add-ons.
+
+namespace base64 {
+
+    namespace detail {
+        // Returns the number of threads to split `length` bytes across: `threads`, or every hardware thread if
+        // zero, but no more than leaves each thread `min_bytes_per_thread`.
+        inline size_t get_thread_count(size_t threads, uint64_t length, size_t min_bytes_per_thread) {
+            if (threads == 0) {
+                threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            }
+            return static_cast<size_t>(std::min<uint64_t>(threads, std::max<uint64_t>(length / std::max<size_t>(min_bytes_per_thread, 1), 1)));
+        }
+
+        // Calls `process(index)` for each index in [0, count), index zero on the calling thread and each of
+        // the others on its own thread.  Every thread is joined even if some throw, after which the exception
+        // from the lowest index is rethrown.  If a thread can't be started, its index and the rest are
+        // processed on the calling thread instead.
+        template<typename Process>
+        inline void run_threads(size_t count, Process&& process) {
+            std::vector<std::exception_ptr> exceptions(count);
+            auto run = [&](size_t index) noexcept {
+                try {
+                    process(index);
+                } catch (...) {
+                    exceptions[index] = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            size_t started = 1;
+            try {
+                workers.reserve(count);
+                for (; started < count; ++started) {
+                    workers.emplace_back(run, started);
+                }
+            } catch (...) {
+            }
+
+            run(0);
+            for (size_t index = started; index < count; ++index) {
+                run(index);
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            for (auto& exception : exceptions) {
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "Base64File.hpp"
+
+// Asynchronous file encoding and decoding with io_uring.  Linux only, and only compiled when
+// BASE64_ENABLE_IO_URING is defined.  Uses the raw system calls, so liburing is not required.
+
+#if defined(BASE64_ENABLE_IO_URING) && defined(__linux__)
+
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <limits>
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+namespace base64 {
+
+    struct UringOptions {
+        // Source bytes per read.  Rounded down to whole groups, and limited so that neither a chunk nor its
+        // output exceeds the 4 GiB that one io_uring operation can transfer.
+        size_t chunk_size = 1024 * 1024;
+
+        // Number of chunks in flight at once, each being read, transcoded or written.
+        unsigned queue_depth = 8;
+
+        // Padding of the encoded output.  Ignored when decoding.
+        bool padded = true;
+
+        Codepath codepath = Codepath::Auto;
+    };
+
+    namespace detail {
+        // A minimal io_uring with a single submitter and reaper.
+        class Uring {
+        public:
+            explicit Uring(unsigned entries) {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+
+                long fd = ::syscall(__NR_io_uring_setup, entries, &params);
+                if (fd < 0) {
+                    throw std::system_error(errno, std::generic_category(), "Unable to create io_uring");
+                }
+                m_fd = static_cast<int>(fd);
+
+                m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                    m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+                }
+
+                m_sq_ring = map(m_sq_ring_size, IORING_OFF_SQ_RING);
+                m_cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? m_sq_ring : map(m_cq_ring_size, IORING_OFF_CQ_RING);
+                m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+                m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, IORING_OFF_SQES));
+
+                auto sq = static_cast<uint8_t*>(m_sq_ring);
+                m_sq_tail = reinterpret_cast<std::atomic<unsigned>*>(sq + params.sq_off.tail);
+                m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+                auto cq = static_cast<uint8_t*>(m_cq_ring);
+                m_cq_head = reinterpret_cast<std::atomic<unsigned>*>(cq + params.cq_off.head);
+                m_cq_tail = reinterpret_cast<std::atomic<unsigned>*>(cq + params.cq_off.tail);
+                m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            }
+
+            ~Uring() {
+                if (m_sqes) {
+                    ::munmap(m_sqes, m_sqes_size);
+                }
+                if (m_cq_ring && m_cq_ring != m_sq_ring) {
+                    ::munmap(m_cq_ring, m_cq_ring_size);
+                }
+                if (m_sq_ring) {
+                    ::munmap(m_sq_ring, m_sq_ring_size);
+                }
+                ::close(m_fd);
+            }
+
+            Uring(const Uring&) = delete;
+            Uring& operator=(const Uring&) = delete;
+
+            // Queues a read or write.  Submitted by the next `Wait`.
+            void Prepare(uint8_t opcode, int fd, void* data, size_t length, uint64_t offset, uint64_t user_data) {
+                unsigned tail = m_sq_tail->load(std::memory_order_relaxed);
+                unsigned index = tail & m_sq_mask;
+
+                io_uring_sqe& sqe = m_sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = opcode;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<uint64_t>(data);
+                sqe.len = static_cast<unsigned>(length);
+                sqe.off = offset;
+                sqe.user_data = user_data;
+
+                m_sq_array[index] = index;
+                m_sq_tail->store(tail + 1, std::memory_order_release);
+                m_pending++;
+            }
+
+            // Submits any queued operations and waits for at least one completion, which is returned.
+            io_uring_cqe Wait() {
+                while (true) {
+                    unsigned head = m_cq_head->load(std::memory_order_relaxed);
+                    if (head != m_cq_tail->load(std::memory_order_acquire) && m_pending == 0) {
+                        io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+                        m_cq_head->store(head + 1, std::memory_order_release);
+                        return cqe;
+                    }
+
+                    long result = ::syscall(__NR_io_uring_enter, m_fd, m_pending, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                    if (result < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+                    }
+                    m_pending -= static_cast<unsigned>(result);
+                }
+            }
+
+        private:
+            int m_fd = -1;
+            void* m_sq_ring = nullptr;
+            void* m_cq_ring = nullptr;
+            io_uring_sqe* m_sqes = nullptr;
+            size_t m_sq_ring_size = 0;
+            size_t m_cq_ring_size = 0;
+            size_t m_sqes_size = 0;
+
+            std::atomic<unsigned>* m_sq_tail = nullptr;
+            unsigned* m_sq_array = nullptr;
+            unsigned m_sq_mask = 0;
+
+            std::atomic<unsigned>* m_cq_head = nullptr;
+            std::atomic<unsigned>* m_cq_tail = nullptr;
+            io_uring_cqe* m_cqes = nullptr;
+            unsigned m_cq_mask = 0;
+
+            unsigned m_pending = 0;
+
+            void* map(size_t length, uint64_t offset) {
+                void* data = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, static_cast<off_t>(offset));
+                if (data == MAP_FAILED) {
+                    throw std::system_error(errno, std::generic_category(), "Unable to map io_uring");
+                }
+                return data;
+            }
+        };
+
+        //----------------------------------------------------------------------------------------------------
+
+        // Reads `source_length` bytes of `source_fd` in chunks of `chunk_size`, transcodes each chunk with
+        // `transcode(chunk_index, input, input_length, output) -> output_length` and writes the result to
+        // `dest_fd` at `get_dest_offset(chunk_index)`.  Up to `queue_depth` chunks are in flight, so reads
+        // and writes for other chunks proceed in the kernel while one is transcoded.
+        template<typename Transcode, typename GetDestOffset>
+        inline void run_uring_pipeline(
+            int source_fd,
+            size_t source_length,
+            int dest_fd,
+            size_t chunk_size,
+            size_t dest_chunk_size,
+            unsigned queue_depth,
+            Transcode&& transcode,
+            GetDestOffset&& get_dest_offset
+        ) {
+            enum Operation : uint64_t { Read = 0, Write = 1 };
+
+            struct Slot {
+                std::vector<uint8_t> input;
+                std::vector<uint8_t> output;
+                size_t chunk = 0;
+                size_t length = 0;  // Of the current operation
+                size_t done = 0;
+            };
+
+            size_t chunk_count = (source_length + chunk_size - 1) / chunk_size;
+            queue_depth = static_cast<unsigned>(std::max<size_t>(std::min<size_t>(queue_depth, chunk_count), 1));
+
+            Uring ring(queue_depth);
+            std::vector<Slot> slots(queue_depth);
+
+            size_t next_chunk = 0;
+            size_t in_flight = 0;
+            int error = 0;
+
+            auto submit_read = [&](size_t index) {
+                Slot& slot = slots[index];
+                ring.Prepare(IORING_OP_READ, source_fd, slot.input.data() + slot.done, slot.length - slot.done,
+                    slot.chunk * chunk_size + slot.done, (uint64_t(Read) << 32) | index);
+            };
+            auto submit_write = [&](size_t index) {
+                Slot& slot = slots[index];
+                ring.Prepare(IORING_OP_WRITE, dest_fd, slot.output.data() + slot.done, slot.length - slot.done,
+                    get_dest_offset(slot.chunk) + slot.done, (uint64_t(Write) << 32) | index);
+            };
+            auto start_chunk = [&](size_t index) {
+                Slot& slot = slots[index];
+                slot.chunk = next_chunk++;
+                slot.length = std::min(chunk_size, source_length - slot.chunk * chunk_size);
+                slot.done = 0;
+                submit_read(index);
+                in_flight++;
+            };
+
+            for (size_t index = 0; index < slots.size() && next_chunk < chunk_count; ++index) {
+                slots[index].input.resize(chunk_size);
+                slots[index].output.resize(dest_chunk_size);
+                start_chunk(index);
+            }
+
+            // After an error or exception, every operation in flight is waited for so that no buffer is freed
+            // while the kernel may still use it.
+            std::exception_ptr exception;
+            while (in_flight != 0) {
+                io_uring_cqe cqe = {};
+                try {
+                    cqe = ring.Wait();
+                } catch (...) {
+                    if (error != 0 || exception) {
+                        // The ring can't be drained, so the buffers are leaked rather than freed under the kernel.
+                        static_cast<void>(new std::vector<Slot>(std::move(slots)));
+                        throw;
+                    }
+                    exception = std::current_exception();
+                    continue;
+                }
+
+                size_t index = static_cast<size_t>(cqe.user_data & 0xFFFFFFFF);
+                auto operation = static_cast<Operation>(cqe.user_data >> 32);
+                Slot& slot = slots[index];
+
+                if (cqe.res <= 0 || error != 0 || exception) {
+                    if (error == 0 && !exception) {
+                        error = (cqe.res < 0) ? -cqe.res : EIO;
+                    }
+                    in_flight--;
+                    continue;
+                }
+
+                slot.done += static_cast<size_t>(cqe.res);
+                if (slot.done < slot.length) {
+                    // Short read or write; continue from where it stopped.
+                    operation == Read ? submit_read(index) : submit_write(index);
+                    continue;
+                }
+
+                if (operation == Read) {
+                    try {
+                        slot.length = transcode(slot.chunk, slot.input.data(), slot.length, slot.output.data());
+                    } catch (...) {
+                        exception = std::current_exception();
+                        in_flight--;
+                        continue;
+                    }
+                    slot.done = 0;
+                    if (slot.length != 0) {
+                        submit_write(index);
+                        continue;
+                    }
+                }
+
+                in_flight--;
+                if (next_chunk < chunk_count) {
+                    start_chunk(index);
+                }
+            }
+
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+            if (error != 0) {
+                throw std::system_error(error, std::generic_category(), "io_uring read or write failed");
+            }
+        }
+
+        // Returns `chunk_size` rounded down to whole groups of `group_size` bytes, and limited so that neither
+        // the chunk nor its output, of at most four bytes per group, is too long for one io_uring operation.
+        inline size_t get_uring_chunk_size(size_t chunk_size, size_t group_size) {
+            constexpr size_t MaxGroups = std::numeric_limits<uint32_t>::max() / 4;
+            return std::min(std::max<size_t>(chunk_size / group_size, 1), MaxGroups) * group_size;
+        }
+
+        // Returns the length of `fd` after removing any trailing line breaks.
+        inline size_t get_trimmed_length(int fd, size_t length) {
+            while (length != 0) {
+                uint8_t last = 0;
+                if (::pread(fd, &last, 1, static_cast<off_t>(length - 1)) != 1 || (last != '\n' && last != '\r')) {
+                    break;
+                }
+                length--;
+            }
+            return length;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Returns true if io_uring can be used, i.e. the kernel supports it and it's not disabled or blocked.
+    inline bool is_io_uring_available() {
+        try {
+            detail::Uring ring(1);
+            return true;
+        } catch (const std::system_error&) {
+            return false;
+        }
+    }
+
+    // Encodes the file at `source_path` into `dest_path`, which is created or replaced, keeping a fixed
+    // number of reads and writes in flight with io_uring so that disk I/O and encoding overlap.  Throws
+    // std::system_error if a file can't be opened, they're the same file or io_uring is unavailable.
+    inline void encode_file_async(const std::string& source_path, const std::string& dest_path, const UringOptions& options = {}) {
+        detail::FileDescriptor source_file(source_path, O_RDONLY);
+        size_t source_length = detail::get_file_size(source_file, source_path);
+        ::posix_fadvise(source_file.Get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        detail::FileDescriptor dest_file(dest_path, O_RDWR | O_CREAT, 0644);
+        detail::check_distinct_files(source_file, dest_file, dest_path);
+        detail::resize_file(dest_file, get_encoded_length(source_length, options.padded), dest_path);
+        if (source_length == 0) {
+            return;
+        }
+
+        size_t chunk_size = detail::get_uring_chunk_size(options.chunk_size, 3);
+        detail::run_uring_pipeline(
+            source_file.Get(), source_length,
+            dest_file.Get(),
+            chunk_size, get_encoded_length(chunk_size),
+            options.queue_depth,
+            [&](size_t, const uint8_t* input, size_t length, uint8_t* output) {
+                size_t output_length = get_encoded_length(length, options.padded);
+                encode(input, length, output, output_length, options.padded, options.codepath);
+                return output_length;
+            },
+            [&](size_t chunk) {
+                return static_cast<uint64_t>(chunk * (chunk_size / 3) * 4);
+            }
+        );
+    }
+
+    // Decodes the base64 file at `source_path` into `dest_path`, which is created or replaced, with
+    // io_uring.  Trailing line breaks are ignored but, as with `decode`, the input is otherwise not
+    // validated.  Throws std::system_error if a file can't be opened, they're the same file or io_uring is
+    // unavailable.
+    inline void decode_file_async(const std::string& source_path, const std::string& dest_path, const UringOptions& options = {}) {
+        detail::FileDescriptor source_file(source_path, O_RDONLY);
+        size_t source_length = detail::get_trimmed_length(source_file.Get(), detail::get_file_size(source_file, source_path));
+        ::posix_fadvise(source_file.Get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        detail::FileDescriptor dest_file(dest_path, O_RDWR | O_CREAT, 0644);
+        detail::check_distinct_files(source_file, dest_file, dest_path);
+        detail::resize_file(dest_file, 0, dest_path);
+        if (source_length == 0) {
+            return;
+        }
+
+        size_t chunk_size = detail::get_uring_chunk_size(options.chunk_size, 4);
+        detail::run_uring_pipeline(
+            source_file.Get(), source_length,
+            dest_file.Get(),
+            chunk_size, (chunk_size / 4) * 3,
+            options.queue_depth,
+            [&](size_t, const uint8_t* input, size_t length, uint8_t* output) {
+                size_t output_length = get_decoded_length(input, length);
+                decode(input, length, output, output_length, options.codepath);
+                return output_length;
+            },
+            [&](size_t chunk) {
+                return static_cast<uint64_t>(chunk * (chunk_size / 4) * 3);
+            }
+        );
+    }
+
+}
+
+#endif
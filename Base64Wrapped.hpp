@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Base64LineIndex.hpp"
+#include "Base64Threads.hpp"
+
+// Multi-threaded decoding of base64 containing whitespace, such as MIME-wrapped email archives.
+
+namespace base64 {
+
+    struct WrappedDecodeOptions {
+        Codepath codepath = Codepath::Auto;
+
+        // Number of threads to split the work across.  Zero uses every hardware thread.  Input is never
+        // split into pieces smaller than `min_bytes_per_thread`.
+        size_t threads = 0;
+        size_t min_bytes_per_thread = 1024 * 1024;
+    };
+
+    namespace detail {
+        // Returns the decoded length of `length` bytes of `data` holding `character_count` encoded characters.
+        // Only the final group, which may be padded, needs reading.
+        inline size_t get_wrapped_decoded_length(const uint8_t* data, size_t length, uint64_t character_count) {
+            size_t final_group_length = get_final_group_length(static_cast<size_t>(character_count));
+            uint8_t final_group[4];
+            for (size_t offset = length, count = final_group_length; count != 0; ) {
+                uint8_t c = data[--offset];
+                if (is_encoded_character(c)) {
+                    final_group[--count] = c;
+                }
+            }
+            return static_cast<size_t>((character_count - final_group_length) / 4 * 3) + get_decoded_length(final_group, final_group_length);
+        }
+
+        // Decodes the groups of characters which start in [begin, end) of `data`, the first having index
+        // `first_character`.  A group which starts before `begin` belongs to the previous piece, so its
+        // characters are skipped; one which starts before `end` but finishes after it is completed from the
+        // characters that follow.
+        inline void decode_wrapped_piece(
+            const uint8_t* data,
+            size_t begin,
+            size_t end,
+            size_t data_length,
+            uint64_t first_character,
+            uint64_t end_character,
+            uint64_t character_count,
+            uint8_t* dest_data,
+            Codepath codepath
+        ) {
+            constexpr size_t BlockCharacters = 64 * 1024;
+
+            uint64_t first_group = (first_character + 3) / 4;
+            uint64_t end_group = (end_character + 3) / 4;
+            if (first_group >= end_group) {
+                return;
+            }
+
+            size_t offset = begin + skip_characters(data + begin, end - begin, static_cast<size_t>(first_group * 4 - first_character));
+            uint64_t remaining = std::min(end_group * 4, character_count) - first_group * 4;
+            dest_data += first_group * 3;
+
+            std::vector<uint8_t> block(static_cast<size_t>(std::min<uint64_t>(remaining, BlockCharacters)));
+            while (remaining != 0) {
+                size_t count = 0;
+                offset += copy_characters(data + offset, data_length - offset, block.data(), static_cast<size_t>(std::min<uint64_t>(remaining, BlockCharacters)), count);
+
+                size_t decoded_length = get_decoded_length(block.data(), count);
+                decode(block.data(), count, dest_data, decoded_length, codepath);
+                dest_data += decoded_length;
+                remaining -= count;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Decodes base64 containing whitespace (anything at or below a space, such as line breaks) on several
+    // threads.  The input is split into equal pieces, whose boundaries needn't fall between groups.  First,
+    // each thread counts the encoded characters in its piece with a vectorized scan, and a prefix sum of the
+    // counts gives the exact character index, and so output offset, at which each piece starts.  Then each
+    // thread decodes the groups starting in its piece, finishing the last from the start of the next piece,
+    // straight into the output.  As with `decode`, the input is otherwise not validated.
+    inline std::vector<uint8_t> decode_wrapped_to_vector(
+        const uint8_t* source_data,
+        const size_t source_data_length,
+        const WrappedDecodeOptions& options = {}
+    ) {
+        size_t threads = detail::get_thread_count(options.threads, source_data_length, options.min_bytes_per_thread);
+        size_t piece_size = (source_data_length + threads - 1) / threads;
+
+        auto get_piece_begin = [&](size_t piece) {
+            return std::min(piece * piece_size, source_data_length);
+        };
+
+        // Phase one: count the characters in each piece.
+        std::vector<uint64_t> characters(threads + 1, 0);
+        detail::run_threads(threads, [&](size_t piece) {
+            size_t begin = get_piece_begin(piece);
+            characters[piece + 1] = detail::count_characters(source_data + begin, get_piece_begin(piece + 1) - begin);
+        });
+        for (size_t piece = 0; piece < threads; ++piece) {
+            characters[piece + 1] += characters[piece];
+        }
+
+        // The final group may be padded, which determines the exact output length.
+        uint64_t character_count = characters[threads];
+        std::vector<uint8_t> result(detail::get_wrapped_decoded_length(source_data, source_data_length, character_count));
+
+        // Phase two: decode each piece into place.
+        detail::run_threads(threads, [&](size_t piece) {
+            detail::decode_wrapped_piece(
+                source_data,
+                get_piece_begin(piece),
+                get_piece_begin(piece + 1),
+                source_data_length,
+                characters[piece],
+                characters[piece + 1],
+                character_count,
+                result.data(),
+                options.codepath
+            );
+        });
+
+        return result;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Returns the decoded length of base64 containing whitespace.
+    inline size_t get_wrapped_decoded_length(const uint8_t* source_data, size_t source_data_length) {
+        return detail::get_wrapped_decoded_length(source_data, source_data_length, detail::count_characters(source_data, source_data_length));
+    }
+
+    // Decodes base64 containing whitespace on the calling thread into `dest_data`, of at least the decoded
+    // length, and returns the decoded length.  The encoded characters are gathered a block at a time into a
+    // buffer on the stack, skipping whitespace with a vectorized scan, and each block is decoded from there.
+    // Output never overtakes input, so `dest_data` may be `source_data` to decode in place.  Throws
+    // std::logic_error if the dest buffer is too small.  As with `decode`, the input is otherwise not
+    // validated.
+    inline size_t decode_wrapped(
+        const uint8_t* source_data,
+        size_t source_data_length,
+        uint8_t* dest_data,
+        size_t dest_data_length,
+        Codepath codepath = Codepath::Auto
+    ) {
+        constexpr size_t BlockCharacters = 4096;
+
+        size_t remaining = detail::count_characters(source_data, source_data_length);
+        size_t decoded_length = detail::get_wrapped_decoded_length(source_data, source_data_length, remaining);
+        if (decoded_length > dest_data_length) {
+            throw std::logic_error("Dest buffer is too small");
+        }
+
+        uint8_t block[BlockCharacters];
+        size_t offset = 0;
+        while (remaining != 0) {
+            size_t count = 0;
+            offset += detail::copy_characters(source_data + offset, source_data_length - offset, block, std::min(remaining, BlockCharacters), count);
+
+            size_t block_decoded_length = get_decoded_length(block, count);
+            decode(block, count, dest_data, block_decoded_length, codepath);
+            dest_data += block_decoded_length;
+            remaining -= count;
+        }
+        return decoded_length;
+    }
+
+}
@@ -0,0 +1,411 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include "Base64.hpp"
+#include "PerfCounters.hpp"
+
+namespace benchmarks {
+
+    // Reads the time stamp counter.  This counts at a constant reference rate, so cycles/byte is in reference
+    // cycles rather than core cycles when the core is running above or below its base frequency.
+    inline uint64_t read_tsc() {
+        return __rdtsc();
+    }
+
+    inline std::string_view to_string(base64::Codepath codepath) {
+        switch (codepath) {
+        case base64::Codepath::Auto: return "Auto";
+        case base64::Codepath::Basic: return "Basic";
+        case base64::Codepath::SSSE3: return "SSSE3";
+        case base64::Codepath::AVX2: return "AVX2";
+        }
+        return "Unknown";
+    }
+
+    // Prevents the optimizer from discarding a result.
+    template <typename T>
+    inline void do_not_optimize(const T& value) {
+#ifdef _MSC_VER
+        volatile const T* ptr = &value;
+        (void)ptr;
+#else
+        asm volatile("" : : "g"(&value) : "memory");
+#endif
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    struct Statistics {
+        double Min = 0;
+        double P10 = 0;
+        double Median = 0;
+        double P90 = 0;
+        double Max = 0;
+    };
+
+    // Linearly interpolated percentile of sorted values, with `percentile` in [0, 1].
+    inline double get_percentile(const std::vector<double>& sorted, double percentile) {
+        if (sorted.empty()) {
+            return 0;
+        }
+
+        double position = percentile * static_cast<double>(sorted.size() - 1);
+        size_t index = static_cast<size_t>(position);
+        if (index + 1 >= sorted.size()) {
+            return sorted.back();
+        }
+
+        double fraction = position - static_cast<double>(index);
+        return sorted[index] + (sorted[index + 1] - sorted[index]) * fraction;
+    }
+
+    inline Statistics get_statistics(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+
+        Statistics stats;
+        if (!values.empty()) {
+            stats.Min = values.front();
+            stats.P10 = get_percentile(values, 0.1);
+            stats.Median = get_percentile(values, 0.5);
+            stats.P90 = get_percentile(values, 0.9);
+            stats.Max = values.back();
+        }
+        return stats;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Identifies a single benchmark.  `Size` is always the binary length, for both directions.
+    struct BenchmarkKey {
+        std::string Direction;
+        std::string Codepath;
+        bool Padded = true;
+        size_t Size = 0;
+
+        auto tie() const {
+            return std::tie(Direction, Codepath, Padded, Size);
+        }
+
+        bool operator<(const BenchmarkKey& other) const {
+            return tie() < other.tie();
+        }
+    };
+
+    struct BenchmarkResult {
+        BenchmarkKey Key;
+        size_t Repetitions = 0;
+        size_t Iterations = 0;
+
+        // Per-call statistics across repetitions.
+        Statistics Nanoseconds;
+        Statistics CyclesPerByte;
+
+        // Derived from the median time per call.
+        double GigabytesPerSecond = 0;
+
+        // Hardware counters per call, across all timed repetitions.  Empty when counters are disabled.
+        std::vector<CounterValue> Counters;
+    };
+
+    struct RunOptions {
+        size_t WarmupRepetitions = 2;
+        size_t Repetitions = 7;
+
+        // Each repetition calls the benchmark until at least this much time has passed.
+        double MinRepetitionMilliseconds = 2.0;
+
+        // Hardware counters to read during the timed repetitions, if any.
+        PerfCounters* Counters = nullptr;
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Calls `fn` the given number of times and returns the elapsed milliseconds.
+    template <typename Fn>
+    inline double time_iterations(size_t iterations, Fn& fn) {
+        using namespace std::chrono;
+
+        auto start = steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            fn();
+        }
+        duration<double, std::milli> elapsed = steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    // Runs `fn` repeatedly and gathers per-call statistics.  The number of calls per repetition is chosen
+    // first so that each repetition lasts at least `MinRepetitionMilliseconds`.
+    template <typename Fn>
+    inline BenchmarkResult run_benchmark(const BenchmarkKey& key, const RunOptions& options, Fn&& fn) {
+        using namespace std::chrono;
+
+        // Find the number of iterations per repetition.  This also serves as the first warm-up.
+        size_t iterations = 1;
+        while (true) {
+            double elapsed = time_iterations(iterations, fn);
+            if (elapsed >= options.MinRepetitionMilliseconds) {
+                break;
+            }
+
+            double scale = options.MinRepetitionMilliseconds / std::max(elapsed, 1e-6);
+            iterations = static_cast<size_t>(static_cast<double>(iterations) * std::min(scale, 1000.0)) + 1;
+        }
+
+        for (size_t warmup = 0; warmup < options.WarmupRepetitions; ++warmup) {
+            time_iterations(iterations, fn);
+        }
+
+        std::vector<double> nanoseconds;
+        std::vector<double> cycles_per_byte;
+        if (options.Counters) {
+            options.Counters->Start();
+        }
+        for (size_t repetition = 0; repetition < options.Repetitions; ++repetition) {
+            auto start = steady_clock::now();
+            uint64_t start_tsc = read_tsc();
+            for (size_t i = 0; i < iterations; ++i) {
+                fn();
+            }
+            uint64_t end_tsc = read_tsc();
+            duration<double, std::nano> elapsed = steady_clock::now() - start;
+
+            double calls = static_cast<double>(iterations);
+            nanoseconds.push_back(elapsed.count() / calls);
+            cycles_per_byte.push_back(
+                static_cast<double>(end_tsc - start_tsc) / calls / static_cast<double>(std::max<size_t>(key.Size, 1))
+            );
+        }
+
+        BenchmarkResult result;
+        if (options.Counters) {
+            result.Counters = options.Counters->Stop(static_cast<double>(iterations * options.Repetitions));
+        }
+        result.Key = key;
+        result.Repetitions = options.Repetitions;
+        result.Iterations = iterations;
+        result.Nanoseconds = get_statistics(std::move(nanoseconds));
+        result.CyclesPerByte = get_statistics(std::move(cycles_per_byte));
+        if (result.Nanoseconds.Median > 0) {
+            result.GigabytesPerSecond = static_cast<double>(key.Size) / result.Nanoseconds.Median;
+        }
+        return result;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    constexpr std::string_view CsvHeader{
+        "direction,codepath,padded,size,repetitions,iterations,"
+        "ns_min,ns_p10,ns_median,ns_p90,ns_max,gbps_median,cpb_p10,cpb_median,cpb_p90"
+    };
+
+    inline void write_csv(std::ostream& stream, const std::vector<BenchmarkResult>& results) {
+        // Counter columns follow the fixed columns, named after the counters of the first result.
+        stream << CsvHeader;
+        if (!results.empty()) {
+            for (auto& counter : results.front().Counters) {
+                stream << ',' << counter.Name;
+            }
+        }
+        stream << '\n';
+
+        for (auto& result : results) {
+            auto& ns = result.Nanoseconds;
+            auto& cpb = result.CyclesPerByte;
+            stream << result.Key.Direction << ','
+                   << result.Key.Codepath << ','
+                   << (result.Key.Padded ? 1 : 0) << ','
+                   << result.Key.Size << ','
+                   << result.Repetitions << ','
+                   << result.Iterations << ','
+                   << ns.Min << ',' << ns.P10 << ',' << ns.Median << ',' << ns.P90 << ',' << ns.Max << ','
+                   << result.GigabytesPerSecond << ','
+                   << cpb.P10 << ',' << cpb.Median << ',' << cpb.P90;
+            for (auto& counter : result.Counters) {
+                stream << ',';
+                if (!std::isnan(counter.Value)) {
+                    stream << counter.Value;
+                }
+            }
+            stream << '\n';
+        }
+    }
+
+    inline void write_json(std::ostream& stream, const std::vector<BenchmarkResult>& results) {
+        auto write_stats = [&](const char* name, const Statistics& stats) {
+            stream << "\"" << name << "\": { "
+                   << "\"min\": " << stats.Min << ", "
+                   << "\"p10\": " << stats.P10 << ", "
+                   << "\"median\": " << stats.Median << ", "
+                   << "\"p90\": " << stats.P90 << ", "
+                   << "\"max\": " << stats.Max << " }";
+        };
+
+        stream << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            auto& result = results[i];
+            stream << "  { "
+                   << "\"direction\": \"" << result.Key.Direction << "\", "
+                   << "\"codepath\": \"" << result.Key.Codepath << "\", "
+                   << "\"padded\": " << (result.Key.Padded ? "true" : "false") << ", "
+                   << "\"size\": " << result.Key.Size << ", "
+                   << "\"repetitions\": " << result.Repetitions << ", "
+                   << "\"iterations\": " << result.Iterations << ", "
+                   << "\"gbps_median\": " << result.GigabytesPerSecond << ", ";
+            write_stats("ns", result.Nanoseconds);
+            stream << ", ";
+            write_stats("cycles_per_byte", result.CyclesPerByte);
+            if (!result.Counters.empty()) {
+                stream << ", \"counters\": { ";
+                for (size_t c = 0; c < result.Counters.size(); ++c) {
+                    auto& counter = result.Counters[c];
+                    stream << (c ? ", " : "") << "\"" << counter.Name << "\": ";
+                    if (std::isnan(counter.Value)) {
+                        stream << "null";
+                    } else {
+                        stream << counter.Value;
+                    }
+                }
+                stream << " }";
+            }
+            stream << " }" << (i + 1 < results.size() ? "," : "") << '\n';
+        }
+        stream << "]\n";
+    }
+
+    inline void write_table_header(std::ostream& stream) {
+        stream << std::left
+               << std::setw(8) << "dir"
+               << std::setw(7) << "path"
+               << std::setw(5) << "pad"
+               << std::right
+               << std::setw(12) << "size"
+               << std::setw(12) << "GB/s"
+               << std::setw(12) << "cyc/B"
+               << std::setw(14) << "ns p10"
+               << std::setw(14) << "ns median"
+               << std::setw(14) << "ns p90" << '\n';
+    }
+
+    inline void write_table_row(std::ostream& stream, const BenchmarkResult& result) {
+        stream << std::left
+               << std::setw(8) << result.Key.Direction
+               << std::setw(7) << result.Key.Codepath
+               << std::setw(5) << (result.Key.Padded ? "yes" : "no")
+               << std::right << std::fixed
+               << std::setw(12) << result.Key.Size
+               << std::setprecision(3)
+               << std::setw(12) << result.GigabytesPerSecond
+               << std::setw(12) << result.CyclesPerByte.Median
+               << std::setprecision(1)
+               << std::setw(14) << result.Nanoseconds.P10
+               << std::setw(14) << result.Nanoseconds.Median
+               << std::setw(14) << result.Nanoseconds.P90 << '\n'
+               << std::defaultfloat << std::setprecision(6);
+
+        // Counters are reported per call on a second line.
+        if (!result.Counters.empty()) {
+            stream << "    ";
+            for (auto& counter : result.Counters) {
+                stream << ' ' << counter.Name << '=';
+                if (std::isnan(counter.Value)) {
+                    stream << '-';
+                } else {
+                    stream << std::setprecision(4) << counter.Value << std::setprecision(6);
+                }
+            }
+            stream << '\n';
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+    //--------------------------------------------------------------------------------------------------------
+
+    // Reads the median throughput of each benchmark from a CSV report written by `write_csv`.
+    inline std::map<BenchmarkKey, double> read_csv_baseline(std::istream& stream) {
+        std::map<BenchmarkKey, double> baseline;
+
+        std::string line;
+        std::getline(stream, line);  // Header
+        while (std::getline(stream, line)) {
+            std::vector<std::string> fields;
+            std::istringstream line_stream(line);
+            std::string field;
+            while (std::getline(line_stream, field, ',')) {
+                fields.push_back(field);
+            }
+            if (fields.size() < 12) {
+                continue;
+            }
+
+            BenchmarkKey key;
+            key.Direction = fields[0];
+            key.Codepath = fields[1];
+            key.Padded = (fields[2] == "1");
+            key.Size = std::stoull(fields[3]);
+            baseline[key] = std::stod(fields[11]);
+        }
+
+        return baseline;
+    }
+
+    // Compares results against a baseline and prints each change in throughput.  Returns the number of
+    // benchmarks which are slower than the baseline by more than `threshold_percent`.
+    inline size_t compare_with_baseline(
+        std::ostream& stream,
+        const std::vector<BenchmarkResult>& results,
+        const std::map<BenchmarkKey, double>& baseline,
+        double threshold_percent
+    ) {
+        size_t regressions = 0;
+        for (auto& result : results) {
+            auto it = baseline.find(result.Key);
+            if (it == baseline.end() || it->second <= 0) {
+                continue;
+            }
+
+            double change = (result.GigabytesPerSecond - it->second) / it->second * 100.0;
+            bool regressed = (change < -threshold_percent);
+            if (regressed) {
+                regressions++;
+            }
+
+            stream << std::left
+                   << std::setw(8) << result.Key.Direction
+                   << std::setw(7) << result.Key.Codepath
+                   << std::setw(5) << (result.Key.Padded ? "yes" : "no")
+                   << std::right << std::fixed << std::setprecision(3)
+                   << std::setw(12) << result.Key.Size
+                   << std::setw(12) << it->second
+                   << std::setw(12) << result.GigabytesPerSecond
+                   << std::setprecision(1)
+                   << std::setw(9) << change << '%'
+                   << (regressed ? "  REGRESSION" : "") << '\n'
+                   << std::defaultfloat << std::setprecision(6);
+        }
+        return regressions;
+    }
+
+}
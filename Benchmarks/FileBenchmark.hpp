@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Base64File.hpp"
+#include "Base64Uring.hpp"
+
+namespace benchmarks {
+
+    struct FileBenchmarkOptions {
+        // Binary file sizes to run.  Encoded files are 4/3 larger.
+        std::vector<size_t> FileSizes = { 16 << 20, 256 << 20 };
+
+        // Directory for the temporary files.  Defaults to the system temporary directory.
+        std::string Directory;
+
+        size_t Repetitions = 5;
+
+        // Chunk size of the read/write and io_uring methods, and the io_uring queue depth.
+        size_t ChunkSize = 1024 * 1024;
+        unsigned QueueDepth = 8;
+    };
+
+    struct FileResult {
+        std::string Direction;
+        std::string Method;
+        size_t Size = 0;
+
+        // Median time and binary bytes per second over the repetitions.
+        double Milliseconds = 0;
+        double GigabytesPerSecond = 0;
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // The synchronous baseline: read a chunk, transcode it, write it, and repeat, with one thread and no
+    // overlap between I/O and transcoding.
+    inline void transcode_file_sync(const std::string& source_path, const std::string& dest_path, bool decode, size_t chunk_size) {
+        base64::detail::FileDescriptor source(source_path, O_RDONLY);
+        base64::detail::FileDescriptor dest(dest_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        chunk_size = decode ? std::max<size_t>(chunk_size / 4, 1) * 4 : std::max<size_t>(chunk_size / 3, 1) * 3;
+        std::vector<uint8_t> input(chunk_size);
+        std::vector<uint8_t> output(base64::get_encoded_length(chunk_size));
+
+        while (true) {
+            size_t length = 0;
+            while (length < chunk_size) {
+                ssize_t count = ::read(source.Get(), input.data() + length, chunk_size - length);
+                if (count < 0) {
+                    base64::detail::throw_file_error("Unable to read", source_path);
+                }
+                if (count == 0) {
+                    break;
+                }
+                length += static_cast<size_t>(count);
+            }
+            if (length == 0) {
+                break;
+            }
+
+            size_t output_length = decode ? base64::get_decoded_length(input.data(), length) : base64::get_encoded_length(length);
+            if (decode) {
+                base64::decode(input.data(), length, output.data(), output_length);
+            } else {
+                base64::encode(input.data(), length, output.data(), output_length);
+            }
+
+            for (size_t offset = 0; offset < output_length; ) {
+                ssize_t count = ::write(dest.Get(), output.data() + offset, output_length - offset);
+                if (count < 0) {
+                    base64::detail::throw_file_error("Unable to write", dest_path);
+                }
+                offset += static_cast<size_t>(count);
+            }
+
+            if (length < chunk_size) {
+                break;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    inline void write_file_header(std::ostream& stream) {
+        stream << std::left
+               << std::setw(8) << "dir"
+               << std::setw(10) << "method"
+               << std::right
+               << std::setw(14) << "size"
+               << std::setw(12) << "ms"
+               << std::setw(12) << "GB/s" << '\n';
+    }
+
+    inline void write_file_row(std::ostream& stream, const FileResult& result) {
+        stream << std::left
+               << std::setw(8) << result.Direction
+               << std::setw(10) << result.Method
+               << std::right << std::fixed
+               << std::setw(14) << result.Size
+               << std::setprecision(3)
+               << std::setw(12) << result.Milliseconds
+               << std::setw(12) << result.GigabytesPerSecond << '\n'
+               << std::defaultfloat << std::setprecision(6);
+    }
+
+    inline void write_file_csv(std::ostream& stream, const std::vector<FileResult>& results) {
+        stream << "direction,method,size,ms,gbps\n";
+        for (auto& result : results) {
+            stream << result.Direction << ','
+                   << result.Method << ','
+                   << result.Size << ','
+                   << result.Milliseconds << ','
+                   << result.GigabytesPerSecond << '\n';
+        }
+    }
+
+    inline void write_file_json(std::ostream& stream, const std::vector<FileResult>& results) {
+        stream << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            auto& result = results[i];
+            stream << "  { "
+                   << "\"direction\": \"" << result.Direction << "\", "
+                   << "\"method\": \"" << result.Method << "\", "
+                   << "\"size\": " << result.Size << ", "
+                   << "\"ms\": " << result.Milliseconds << ", "
+                   << "\"gbps\": " << result.GigabytesPerSecond
+                   << " }" << (i + 1 < results.size() ? "," : "") << '\n';
+        }
+        stream << "]\n";
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Times file to file encoding and decoding with synchronous reads and writes, memory mapping and, where
+    // built and available, io_uring.  The files are written once and then read from the page cache, so the
+    // results compare the overheads of each method rather than the speed of the disk.
+    inline std::vector<FileResult> run_file_benchmarks(
+        const FileBenchmarkOptions& options,
+        const std::vector<std::string>& directions,
+        std::ostream* progress
+    ) {
+        namespace fs = std::filesystem;
+        using namespace std::chrono;
+
+        fs::path directory = options.Directory.empty() ? fs::temp_directory_path() : fs::path(options.Directory);
+        fs::path binary_path = directory / ("base64_benchmark_" + std::to_string(::getpid()) + ".bin");
+        fs::path encoded_path = directory / ("base64_benchmark_" + std::to_string(::getpid()) + ".txt");
+        fs::path output_path = directory / ("base64_benchmark_" + std::to_string(::getpid()) + ".out");
+
+        std::vector<std::pair<std::string, std::function<void(const std::string&, const std::string&, bool)>>> methods;
+        methods.emplace_back("read", [&](const std::string& source, const std::string& dest, bool decode) {
+            transcode_file_sync(source, dest, decode, options.ChunkSize);
+        });
+        methods.emplace_back("mmap", [](const std::string& source, const std::string& dest, bool decode) {
+            decode ? base64::decode_file(source, dest) : base64::encode_file(source, dest);
+        });
+#if defined(BASE64_ENABLE_IO_URING) && defined(__linux__)
+        if (base64::is_io_uring_available()) {
+            methods.emplace_back("io_uring", [&](const std::string& source, const std::string& dest, bool decode) {
+                base64::UringOptions uring;
+                uring.chunk_size = options.ChunkSize;
+                uring.queue_depth = options.QueueDepth;
+                decode ? base64::decode_file_async(source, dest, uring) : base64::encode_file_async(source, dest, uring);
+            });
+        }
+#endif
+
+        std::vector<FileResult> results;
+        for (size_t size : options.FileSizes) {
+            {
+                std::vector<uint8_t> binary(size);
+                for (size_t i = 0; i < size; ++i) {
+                    binary[i] = static_cast<uint8_t>(i * 167 + 13);
+                }
+                std::ofstream(binary_path, std::ios::binary | std::ios::trunc)
+                    .write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(size));
+            }
+            base64::encode_file(binary_path.string(), encoded_path.string());
+
+            for (auto& direction : directions) {
+                bool decode = (direction == "decode");
+                const fs::path& source = decode ? encoded_path : binary_path;
+
+                for (auto& method : methods) {
+                    // One untimed run to create the output file and fault in the page cache.
+                    method.second(source.string(), output_path.string(), decode);
+
+                    std::vector<double> times;
+                    for (size_t repetition = 0; repetition < options.Repetitions; ++repetition) {
+                        auto start = steady_clock::now();
+                        method.second(source.string(), output_path.string(), decode);
+                        duration<double, std::milli> elapsed = steady_clock::now() - start;
+                        times.push_back(elapsed.count());
+                    }
+                    std::sort(times.begin(), times.end());
+
+                    FileResult result;
+                    result.Direction = direction;
+                    result.Method = method.first;
+                    result.Size = size;
+                    result.Milliseconds = times[times.size() / 2];
+                    result.GigabytesPerSecond = static_cast<double>(size) / (result.Milliseconds * 1e6);
+                    results.push_back(result);
+
+                    if (progress) {
+                        write_file_row(*progress, result);
+                    }
+                }
+            }
+        }
+
+        std::error_code error;
+        fs::remove(binary_path, error);
+        fs::remove(encoded_path, error);
+        fs::remove(output_path, error);
+        return results;
+    }
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "CpuFeatures.hpp"
+
+namespace benchmarks {
+
+    // A named counter value.  NaN when the counter could not be read.
+    struct CounterValue {
+        std::string Name;
+        double Value = NAN;
+    };
+
+    // Hardware performance counters read through perf_event_open.  Each counter is opened separately so that
+    // those which aren't supported, or aren't permitted, are simply left out.  When none can be opened the
+    // counters report `IsAvailable() == false` and benchmarking continues without them.
+    class PerfCounters {
+    public:
+        // `port_counters` adds uops dispatched per execution port.  These use raw Skylake-family event
+        // encodings, so are only attempted on Intel CPUs and may be meaningless on other microarchitectures.
+        explicit PerfCounters(bool port_counters) {
+#ifdef __linux__
+            add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions");
+            add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles");
+            add(PERF_TYPE_HW_CACHE,
+                PERF_COUNT_HW_CACHE_L1D |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                "l1d_misses");
+            add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "llc_misses");
+            add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses");
+
+            if (port_counters && is_intel()) {
+                // UOPS_DISPATCHED.PORT_n: event 0xA1, umask (1 << n)
+                for (uint64_t port = 0; port < 8; ++port) {
+                    add(PERF_TYPE_RAW, 0xA1 | ((uint64_t(1) << port) << 8), "uops_port" + std::to_string(port));
+                }
+            }
+#else
+            (void)port_counters;
+            m_error = "perf_event_open is only available on Linux";
+#endif
+        }
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (auto& counter : m_counters) {
+                close(counter.Fd);
+            }
+#endif
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool IsAvailable() const {
+            return !m_counters.empty();
+        }
+
+        // Describes why the first counter could not be opened, if any failed.
+        const std::string& GetError() const {
+            return m_error;
+        }
+
+        // Names of the counters reported by `Stop`, including derived values.
+        std::vector<std::string> GetNames() const {
+            std::vector<std::string> names;
+            for (auto& counter : m_counters) {
+                names.push_back(counter.Name);
+            }
+            if (IsAvailable()) {
+                names.push_back("ipc");
+            }
+            return names;
+        }
+
+        void Start() {
+#ifdef __linux__
+            for (auto& counter : m_counters) {
+                ioctl(counter.Fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(counter.Fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        // Stops counting and returns each counter divided by `divisor`, usually the number of calls.  Values
+        // are scaled up when the kernel had to multiplex counters.
+        std::vector<CounterValue> Stop(double divisor) {
+            std::vector<CounterValue> values;
+#ifdef __linux__
+            for (auto& counter : m_counters) {
+                ioctl(counter.Fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+
+            double instructions = NAN;
+            double cycles = NAN;
+            for (auto& counter : m_counters) {
+                CounterValue value;
+                value.Name = counter.Name;
+
+                // Layout given by PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+                uint64_t data[3] = {};
+                if (read(counter.Fd, data, sizeof(data)) == sizeof(data) && data[2] != 0) {
+                    double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+                    value.Value = static_cast<double>(data[0]) * scale / divisor;
+                }
+
+                if (counter.Name == "instructions") {
+                    instructions = value.Value;
+                } else if (counter.Name == "cycles") {
+                    cycles = value.Value;
+                }
+                values.push_back(std::move(value));
+            }
+
+            if (IsAvailable()) {
+                values.push_back({ "ipc", instructions / cycles });
+            }
+#else
+            (void)divisor;
+#endif
+            return values;
+        }
+
+    private:
+        struct Counter {
+            std::string Name;
+            int Fd = -1;
+        };
+
+        std::vector<Counter> m_counters;
+        std::string m_error;
+
+#ifdef __linux__
+        static bool is_intel() {
+            std::array<int, 4> info = {0};
+            cpu_features::detail::cpuid(info, 0);
+            return info[1] == 0x756e6547 && info[3] == 0x49656e69 && info[2] == 0x6c65746e;  // "GenuineIntel"
+        }
+
+        void add(uint32_t type, uint64_t config, std::string name) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fd < 0) {
+                if (m_error.empty()) {
+                    m_error = "Unable to open " + name + ": " + std::strerror(errno);
+                    if (errno == EACCES || errno == EPERM) {
+                        m_error += " (check /proc/sys/kernel/perf_event_paranoid)";
+                    }
+                }
+                return;
+            }
+
+            m_counters.push_back({ std::move(name), static_cast<int>(fd) });
+        }
+#endif
+    };
+
+}
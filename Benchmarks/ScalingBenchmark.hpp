@@ -0,0 +1,251 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkHarness.hpp"
+
+namespace benchmarks {
+
+    struct ScalingOptions {
+        // Thread counts to run.  Defaults to powers of two up to, and including, every hardware thread.
+        std::vector<size_t> ThreadCounts;
+
+        // Binary bytes processed per call by each thread.  Defaults span L1, L2, LLC and DRAM.
+        std::vector<size_t> WorkingSets = { 16 << 10, 256 << 10, 4 << 20, 64 << 20 };
+
+        // How long each measurement runs.
+        double DurationMilliseconds = 250;
+    };
+
+    struct ScalingResult {
+        std::string Direction;
+        std::string Codepath;
+        size_t Threads = 0;
+        size_t WorkingSet = 0;
+
+        // Aggregate binary bytes per second across all threads.
+        double GigabytesPerSecond = 0;
+
+        // Aggregate bytes copied per second by memcpy with the same threads and working set.
+        double MemcpyGigabytesPerSecond = 0;
+    };
+
+    inline std::vector<size_t> get_default_thread_counts() {
+        size_t hardware_threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+        std::vector<size_t> counts;
+        for (size_t count = 1; count < hardware_threads; count *= 2) {
+            counts.push_back(count);
+        }
+        counts.push_back(hardware_threads);
+        return counts;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Runs a benchmark on `thread_count` threads at once and returns the aggregate GB/s.  Each thread calls
+    // `setup` to allocate its private buffers, so that they are first touched by the thread using them, and
+    // then repeatedly calls the function it returns until the duration has passed.
+    inline double measure_aggregate_throughput(
+        size_t thread_count,
+        double duration_milliseconds,
+        size_t bytes_per_call,
+        const std::function<std::function<void()>()>& setup
+    ) {
+        using namespace std::chrono;
+
+        std::atomic<size_t> ready{ 0 };
+        std::atomic<bool> start{ false };
+        std::atomic<bool> stop{ false };
+        std::vector<double> throughput(thread_count);
+
+        std::vector<std::thread> threads;
+        for (size_t index = 0; index < thread_count; ++index) {
+            threads.emplace_back([&, index] {
+                auto work = setup();
+                work();  // Warm-up, also faults in the output pages.
+
+                ready++;
+                while (!start.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+
+                size_t calls = 0;
+                auto begin = steady_clock::now();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    work();
+                    calls++;
+                }
+                duration<double, std::nano> elapsed = steady_clock::now() - begin;
+
+                throughput[index] = static_cast<double>(calls * bytes_per_call) / elapsed.count();
+            });
+        }
+
+        while (ready.load() != thread_count) {
+            std::this_thread::yield();
+        }
+        start.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(duration<double, std::milli>(duration_milliseconds));
+        stop.store(true, std::memory_order_relaxed);
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        double total = 0;
+        for (auto value : throughput) {
+            total += value;
+        }
+        return total;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    inline void write_scaling_header(std::ostream& stream) {
+        stream << std::left
+               << std::setw(8) << "dir"
+               << std::setw(7) << "path"
+               << std::right
+               << std::setw(9) << "threads"
+               << std::setw(14) << "working set"
+               << std::setw(12) << "GB/s"
+               << std::setw(14) << "memcpy GB/s"
+               << std::setw(10) << "ratio" << '\n';
+    }
+
+    inline void write_scaling_row(std::ostream& stream, const ScalingResult& result) {
+        double ratio = result.MemcpyGigabytesPerSecond > 0
+            ? result.GigabytesPerSecond / result.MemcpyGigabytesPerSecond
+            : 0;
+
+        stream << std::left
+               << std::setw(8) << result.Direction
+               << std::setw(7) << result.Codepath
+               << std::right << std::fixed
+               << std::setw(9) << result.Threads
+               << std::setw(14) << result.WorkingSet
+               << std::setprecision(3)
+               << std::setw(12) << result.GigabytesPerSecond
+               << std::setw(14) << result.MemcpyGigabytesPerSecond
+               << std::setw(10) << ratio << '\n'
+               << std::defaultfloat << std::setprecision(6);
+    }
+
+    inline void write_scaling_csv(std::ostream& stream, const std::vector<ScalingResult>& results) {
+        stream << "direction,codepath,threads,working_set,gbps,memcpy_gbps\n";
+        for (auto& result : results) {
+            stream << result.Direction << ','
+                   << result.Codepath << ','
+                   << result.Threads << ','
+                   << result.WorkingSet << ','
+                   << result.GigabytesPerSecond << ','
+                   << result.MemcpyGigabytesPerSecond << '\n';
+        }
+    }
+
+    inline void write_scaling_json(std::ostream& stream, const std::vector<ScalingResult>& results) {
+        stream << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            auto& result = results[i];
+            stream << "  { "
+                   << "\"direction\": \"" << result.Direction << "\", "
+                   << "\"codepath\": \"" << result.Codepath << "\", "
+                   << "\"threads\": " << result.Threads << ", "
+                   << "\"working_set\": " << result.WorkingSet << ", "
+                   << "\"gbps\": " << result.GigabytesPerSecond << ", "
+                   << "\"memcpy_gbps\": " << result.MemcpyGigabytesPerSecond
+                   << " }" << (i + 1 < results.size() ? "," : "") << '\n';
+        }
+        stream << "]\n";
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Measures encode and decode throughput as threads are added, for each working set size, alongside the
+    // memcpy bandwidth for the same configuration.  Where the base64 throughput stops growing with threads
+    // and approaches the memcpy figure, the workload has become memory bound.
+    inline std::vector<ScalingResult> run_scaling(
+        const ScalingOptions& options,
+        const std::vector<base64::Codepath>& codepaths,
+        const std::vector<std::string>& directions,
+        std::ostream* progress
+    ) {
+        auto thread_counts = options.ThreadCounts.empty() ? get_default_thread_counts() : options.ThreadCounts;
+
+        std::vector<ScalingResult> results;
+        for (size_t working_set : options.WorkingSets) {
+            for (size_t threads : thread_counts) {
+                double memcpy_gbps = measure_aggregate_throughput(
+                    threads, options.DurationMilliseconds, working_set,
+                    [=]() -> std::function<void()> {
+                        auto source = std::make_shared<std::vector<uint8_t>>(working_set, uint8_t(1));
+                        auto dest = std::make_shared<std::vector<uint8_t>>(working_set);
+                        return [=] {
+                            std::memcpy(dest->data(), source->data(), working_set);
+                            do_not_optimize((*dest)[0]);
+                        };
+                    }
+                );
+
+                for (auto codepath : codepaths) {
+                    if (codepath != base64::Codepath::Auto && !base64::is_codepath_supported(codepath)) {
+                        continue;
+                    }
+
+                    for (auto& direction : directions) {
+                        bool decode = (direction == "decode");
+                        double gbps = measure_aggregate_throughput(
+                            threads, options.DurationMilliseconds, working_set,
+                            [=]() -> std::function<void()> {
+                                auto binary = std::make_shared<std::vector<uint8_t>>(working_set);
+                                for (size_t i = 0; i < working_set; ++i) {
+                                    (*binary)[i] = static_cast<uint8_t>(i * 167 + 13);
+                                }
+                                auto encoded = std::make_shared<std::vector<uint8_t>>(
+                                    base64::encode_to_byte_vector(binary->data(), working_set)
+                                );
+
+                                if (decode) {
+                                    return [=] {
+                                        base64::decode(encoded->data(), encoded->size(), binary->data(), working_set, codepath);
+                                        do_not_optimize((*binary)[0]);
+                                    };
+                                }
+                                return [=] {
+                                    base64::encode(binary->data(), working_set, encoded->data(), encoded->size(), true, codepath);
+                                    do_not_optimize((*encoded)[0]);
+                                };
+                            }
+                        );
+
+                        ScalingResult result;
+                        result.Direction = direction;
+                        result.Codepath = std::string(to_string(codepath));
+                        result.Threads = threads;
+                        result.WorkingSet = working_set;
+                        result.GigabytesPerSecond = gbps;
+                        result.MemcpyGigabytesPerSecond = memcpy_gbps;
+                        results.push_back(result);
+
+                        if (progress) {
+                            write_scaling_row(*progress, result);
+                        }
+                    }
+                }
+            }
+        }
+
+        return results;
+    }
+
+}
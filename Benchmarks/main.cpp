@@ -0,0 +1,422 @@
+#include "BenchmarkHarness.hpp"
+#include "FileBenchmark.hpp"
+#include "ScalingBenchmark.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+namespace {
+
+    enum class ReportFormat {
+        Table,
+        Csv,
+        Json
+    };
+
+    struct Options {
+        size_t MinSize = 1;
+        size_t MaxSize = size_t(1) << 30;
+        size_t Step = 2;
+        std::vector<base64::Codepath> Codepaths;
+        std::vector<std::string> Directions;
+        ReportFormat Format = ReportFormat::Table;
+        std::string OutputPath;
+        std::string BaselinePath;
+        double ThresholdPercent = 5.0;
+        bool Counters = false;
+        bool PortCounters = false;
+        bool Scaling = false;
+        bool Files = false;
+        benchmarks::RunOptions Run;
+        benchmarks::ScalingOptions ScalingRun;
+        benchmarks::FileBenchmarkOptions FileRun;
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    void print_usage() {
+        std::cout
+            << "Usage: Benchmarks [<options>]\n"
+            << "    -h, --help:             Displays this message\n"
+            << "        --min-size <n>:     Smallest binary size, in bytes (K/M/G suffixes allowed, default 1)\n"
+            << "        --max-size <n>:     Largest binary size (default 1G)\n"
+            << "        --step <n>:         Size multiplier between benchmarks (default 2)\n"
+            << "        --codepath <name>:  basic, ssse3 or avx2.  May be repeated (default all supported)\n"
+            << "        --direction <name>: encode or decode.  May be repeated (default both)\n"
+            << "        --repetitions <n>:  Timed repetitions per benchmark (default 7)\n"
+            << "        --warmup <n>:       Untimed repetitions per benchmark (default 2)\n"
+            << "        --min-time <ms>:    Minimum duration of each repetition (default 2)\n"
+            << "        --streaming-threshold <n>: Size at which non-temporal stores are used (default never)\n"
+            << "        --format <name>:    table, csv or json (default table)\n"
+            << "        --output <path>:    Write the report to a file rather than stdout\n"
+            << "        --baseline <path>:  Compare against a CSV report from a previous run\n"
+            << "        --threshold <pct>:  Slowdown reported as a regression (default 5)\n"
+            << "        --counters:         Read hardware performance counters (Linux perf_event_open)\n"
+            << "        --port-counters:    Also read uops dispatched per port (Intel Skylake-family encodings)\n"
+            << "\n"
+            << "    --scaling:              Measure multi-threaded throughput against memcpy bandwidth instead\n"
+            << "        --threads <list>:   Comma separated thread counts (default powers of two up to all threads)\n"
+            << "        --working-sets <list>: Comma separated bytes per thread (default 16K,256K,4M,64M)\n"
+            << "        --duration <ms>:    Duration of each measurement (default 250)\n"
+            << "\n"
+            << "    --files:                Time file to file transcoding with read/write, mmap and io_uring instead\n"
+            << "        --file-sizes <list>: Comma separated binary file sizes (default 16M,256M)\n"
+            << "        --file-dir <path>:  Directory for the temporary files (default the system temporary directory)\n"
+            << "        --chunk-size <n>:   Bytes per read of the read/write and io_uring methods (default 1M)\n"
+            << "        --queue-depth <n>:  Chunks in flight with io_uring (default 8)\n";
+    }
+
+    size_t parse_size(const std::string& text) {
+        size_t end = 0;
+        size_t value = std::stoull(text, &end);
+        if (end < text.size()) {
+            switch (text[end]) {
+            case 'k': case 'K': value <<= 10; break;
+            case 'm': case 'M': value <<= 20; break;
+            case 'g': case 'G': value <<= 30; break;
+            default: throw std::invalid_argument("Invalid size: " + text);
+            }
+        }
+        return value;
+    }
+
+    std::vector<size_t> parse_size_list(const std::string& text) {
+        std::vector<size_t> values;
+        std::istringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            values.push_back(std::max<size_t>(parse_size(item), 1));
+        }
+        return values;
+    }
+
+    base64::Codepath parse_codepath(const std::string& text) {
+        if (text == "basic") { return base64::Codepath::Basic; }
+        if (text == "ssse3") { return base64::Codepath::SSSE3; }
+        if (text == "avx2") { return base64::Codepath::AVX2; }
+        throw std::invalid_argument("Invalid codepath: " + text);
+    }
+
+    bool parse_options(int argc, const char* argv[], Options& options) {
+        for (int index = 1; index < argc; ++index) {
+            std::string arg = argv[index];
+            if (arg == "-h" || arg == "--help") {
+                print_usage();
+                return false;
+            }
+            if (arg == "--counters") {
+                options.Counters = true;
+                continue;
+            }
+            if (arg == "--port-counters") {
+                options.Counters = true;
+                options.PortCounters = true;
+                continue;
+            }
+            if (arg == "--scaling") {
+                options.Scaling = true;
+                continue;
+            }
+            if (arg == "--files") {
+                options.Files = true;
+                continue;
+            }
+
+            if (index + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            std::string value = argv[++index];
+
+            if (arg == "--min-size") {
+                options.MinSize = std::max<size_t>(parse_size(value), 1);
+            } else if (arg == "--max-size") {
+                options.MaxSize = parse_size(value);
+            } else if (arg == "--step") {
+                options.Step = std::max<size_t>(std::stoull(value), 2);
+            } else if (arg == "--codepath") {
+                options.Codepaths.push_back(parse_codepath(value));
+            } else if (arg == "--direction") {
+                if (value != "encode" && value != "decode") {
+                    throw std::invalid_argument("Invalid direction: " + value);
+                }
+                options.Directions.push_back(value);
+            } else if (arg == "--repetitions") {
+                options.Run.Repetitions = std::max<size_t>(std::stoull(value), 1);
+                options.FileRun.Repetitions = options.Run.Repetitions;
+            } else if (arg == "--warmup") {
+                options.Run.WarmupRepetitions = std::stoull(value);
+            } else if (arg == "--min-time") {
+                options.Run.MinRepetitionMilliseconds = std::stod(value);
+            } else if (arg == "--streaming-threshold") {
+                base64::set_streaming_threshold(parse_size(value));
+            } else if (arg == "--format") {
+                if (value == "table") { options.Format = ReportFormat::Table; }
+                else if (value == "csv") { options.Format = ReportFormat::Csv; }
+                else if (value == "json") { options.Format = ReportFormat::Json; }
+                else { throw std::invalid_argument("Invalid format: " + value); }
+            } else if (arg == "--output") {
+                options.OutputPath = value;
+            } else if (arg == "--baseline") {
+                options.BaselinePath = value;
+            } else if (arg == "--threshold") {
+                options.ThresholdPercent = std::stod(value);
+            } else if (arg == "--threads") {
+                options.ScalingRun.ThreadCounts = parse_size_list(value);
+            } else if (arg == "--working-sets") {
+                options.ScalingRun.WorkingSets = parse_size_list(value);
+            } else if (arg == "--duration") {
+                options.ScalingRun.DurationMilliseconds = std::stod(value);
+            } else if (arg == "--file-sizes") {
+                options.FileRun.FileSizes = parse_size_list(value);
+            } else if (arg == "--file-dir") {
+                options.FileRun.Directory = value;
+            } else if (arg == "--chunk-size") {
+                options.FileRun.ChunkSize = std::max<size_t>(parse_size(value), 1);
+            } else if (arg == "--queue-depth") {
+                options.FileRun.QueueDepth = static_cast<unsigned>(std::max<size_t>(std::stoull(value), 1));
+            } else {
+                throw std::invalid_argument("Unknown option: " + arg);
+            }
+        }
+
+        if (options.Codepaths.empty()) {
+            // Scaling is about the memory system rather than the kernels, so only uses the default codepath.
+            if (options.Scaling) {
+                options.Codepaths = { base64::Codepath::Auto };
+            } else {
+                options.Codepaths = { base64::Codepath::Basic, base64::Codepath::SSSE3, base64::Codepath::AVX2 };
+            }
+        }
+        if (options.Directions.empty()) {
+            options.Directions = { "encode", "decode" };
+        }
+        return true;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    std::vector<benchmarks::BenchmarkResult> run_sweep(const Options& options) {
+        using namespace benchmarks;
+
+        bool run_encode = std::find(options.Directions.begin(), options.Directions.end(), "encode") != options.Directions.end();
+        bool run_decode = std::find(options.Directions.begin(), options.Directions.end(), "decode") != options.Directions.end();
+
+        // Buffers are sized for the largest benchmark and shared by all of them.  Uninitialized allocations
+        // avoid touching several GiB up front; the data is written before it's read.
+        size_t max_encoded = base64::get_encoded_length(options.MaxSize);
+        std::unique_ptr<uint8_t[]> binary(new uint8_t[options.MaxSize]);
+        std::unique_ptr<uint8_t[]> encoded(new uint8_t[max_encoded]);
+        std::unique_ptr<uint8_t[]> decoded(new uint8_t[options.MaxSize]);
+
+        uint32_t seed = 0x12345678;
+        for (size_t i = 0; i < options.MaxSize; ++i) {
+            seed = seed * 1664525 + 1013904223;
+            binary[i] = static_cast<uint8_t>(seed >> 24);
+        }
+
+        bool table = (options.Format == ReportFormat::Table && options.OutputPath.empty());
+        if (table) {
+            write_table_header(std::cout);
+        }
+
+        std::vector<BenchmarkResult> results;
+        for (size_t size = options.MinSize; size <= options.MaxSize; size *= options.Step) {
+            for (auto codepath : options.Codepaths) {
+                if (!base64::is_codepath_supported(codepath)) {
+                    continue;
+                }
+
+                for (bool padded : { true, false }) {
+                    size_t encoded_length = base64::get_encoded_length(size, padded);
+
+                    BenchmarkKey key;
+                    key.Codepath = std::string(to_string(codepath));
+                    key.Padded = padded;
+                    key.Size = size;
+
+                    // Always encode, as decoding needs the encoded data.
+                    key.Direction = "encode";
+                    auto encode_result = run_benchmark(key, options.Run, [&] {
+                        base64::encode(binary.get(), size, encoded.get(), encoded_length, padded, codepath);
+                        do_not_optimize(encoded[0]);
+                    });
+                    if (run_encode) {
+                        results.push_back(encode_result);
+                        if (table) {
+                            write_table_row(std::cout, results.back());
+                        }
+                    }
+
+                    if (run_decode) {
+                        key.Direction = "decode";
+                        results.push_back(run_benchmark(key, options.Run, [&] {
+                            base64::decode(encoded.get(), encoded_length, decoded.get(), size, codepath);
+                            do_not_optimize(decoded[0]);
+                        }));
+                        if (table) {
+                            write_table_row(std::cout, results.back());
+                        }
+
+                        if (std::memcmp(binary.get(), decoded.get(), size) != 0) {
+                            throw std::runtime_error("Decoded data does not match the source");
+                        }
+                    }
+                }
+            }
+
+            if (size > options.MaxSize / options.Step) {
+                break;
+            }
+        }
+
+        return results;
+    }
+
+    void run_files(const Options& options) {
+        bool table = (options.Format == ReportFormat::Table && options.OutputPath.empty());
+        if (table) {
+            benchmarks::write_file_header(std::cout);
+        }
+
+        auto results = benchmarks::run_file_benchmarks(
+            options.FileRun,
+            options.Directions,
+            table ? &std::cout : nullptr
+        );
+
+        std::ofstream file;
+        if (!options.OutputPath.empty()) {
+            file.open(options.OutputPath, std::ios::trunc);
+        }
+        std::ostream& output = options.OutputPath.empty() ? std::cout : file;
+
+        switch (options.Format) {
+        case ReportFormat::Csv: benchmarks::write_file_csv(output, results); break;
+        case ReportFormat::Json: benchmarks::write_file_json(output, results); break;
+        case ReportFormat::Table:
+            if (!options.OutputPath.empty()) {
+                benchmarks::write_file_header(output);
+                for (auto& result : results) {
+                    benchmarks::write_file_row(output, result);
+                }
+            }
+            break;
+        }
+    }
+
+    void run_scaling(const Options& options) {
+        bool table = (options.Format == ReportFormat::Table && options.OutputPath.empty());
+        if (table) {
+            benchmarks::write_scaling_header(std::cout);
+        }
+
+        auto results = benchmarks::run_scaling(
+            options.ScalingRun,
+            options.Codepaths,
+            options.Directions,
+            table ? &std::cout : nullptr
+        );
+
+        std::ofstream file;
+        if (!options.OutputPath.empty()) {
+            file.open(options.OutputPath, std::ios::trunc);
+        }
+        std::ostream& output = options.OutputPath.empty() ? std::cout : file;
+
+        switch (options.Format) {
+        case ReportFormat::Csv: benchmarks::write_scaling_csv(output, results); break;
+        case ReportFormat::Json: benchmarks::write_scaling_json(output, results); break;
+        case ReportFormat::Table:
+            if (!options.OutputPath.empty()) {
+                benchmarks::write_scaling_header(output);
+                for (auto& result : results) {
+                    benchmarks::write_scaling_row(output, result);
+                }
+            }
+            break;
+        }
+    }
+
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[]) {
+    try {
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            return 2;
+        }
+
+        if (options.Scaling) {
+            run_scaling(options);
+            return 0;
+        }
+        if (options.Files) {
+            run_files(options);
+            return 0;
+        }
+
+        // Counters are optional; without permission to read them benchmarks still run.
+        std::unique_ptr<benchmarks::PerfCounters> counters;
+        if (options.Counters) {
+            counters = std::make_unique<benchmarks::PerfCounters>(options.PortCounters);
+            if (!counters->GetError().empty()) {
+                std::cerr << "Note: " << counters->GetError() << std::endl;
+            }
+            if (counters->IsAvailable()) {
+                options.Run.Counters = counters.get();
+            } else {
+                std::cerr << "Note: hardware counters are unavailable; reporting timings only" << std::endl;
+            }
+        }
+
+        auto results = run_sweep(options);
+
+        std::ofstream file;
+        if (!options.OutputPath.empty()) {
+            file.open(options.OutputPath, std::ios::trunc);
+        }
+        std::ostream& output = options.OutputPath.empty() ? std::cout : file;
+
+        switch (options.Format) {
+        case ReportFormat::Csv: benchmarks::write_csv(output, results); break;
+        case ReportFormat::Json: benchmarks::write_json(output, results); break;
+        case ReportFormat::Table:
+            if (!options.OutputPath.empty()) {
+                benchmarks::write_table_header(output);
+                for (auto& result : results) {
+                    benchmarks::write_table_row(output, result);
+                }
+            }
+            break;
+        }
+
+        if (!options.BaselinePath.empty()) {
+            std::ifstream baseline_file(options.BaselinePath);
+            if (!baseline_file) {
+                throw std::runtime_error("Unable to open baseline: " + options.BaselinePath);
+            }
+
+            std::cerr << "\nComparison with " << options.BaselinePath << ":\n";
+            size_t regressions = benchmarks::compare_with_baseline(
+                std::cerr,
+                results,
+                benchmarks::read_csv_baseline(baseline_file),
+                options.ThresholdPercent
+            );
+            if (regressions != 0) {
+                std::cerr << regressions << " regression(s) beyond " << options.ThresholdPercent << "%\n";
+                return 1;
+            }
+        }
+
+        return 0;
+
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+namespace cli {
+
+    // Size of the buffers passed between the reader, transcoder and writer.  A multiple of three so that
+    // every chunk but the last can be encoded without carrying bytes over.
+    constexpr size_t ChunkSize = 3 * 1024 * 1024;
+
+    // Number of buffers in each direction.  Two lets one stage fill a buffer while the next drains the other.
+    constexpr size_t BufferCount = 2;
+
+    // A blocking queue between two threads.  `Pop` returns nothing once the queue is closed and empty.
+    template<typename T>
+    class Channel {
+    public:
+        void Push(T value) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_items.push_back(std::move(value));
+            }
+            m_condition.notify_one();
+        }
+
+        std::optional<T> Pop() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return !m_items.empty() || m_closed; });
+            if (m_items.empty()) {
+                return std::nullopt;
+            }
+
+            T value = std::move(m_items.front());
+            m_items.pop_front();
+            return value;
+        }
+
+        void Close() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_condition.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<T> m_items;
+        bool m_closed = false;
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Reads until `length` bytes have been read or the end of the file.  Returns the number of bytes read.
+    inline size_t read_full(int fd, uint8_t* data, size_t length) {
+        size_t total = 0;
+        while (total < length) {
+            ssize_t count = ::read(fd, data + total, length - total);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "read error");
+            }
+            if (count == 0) {
+                break;
+            }
+            total += static_cast<size_t>(count);
+        }
+        return total;
+    }
+
+    inline void write_full(int fd, const uint8_t* data, size_t length) {
+        while (length != 0) {
+            ssize_t count = ::write(fd, data, length);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "write error");
+            }
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // A buffer passed between threads.  `Last` marks the final input chunk.
+    struct Buffer {
+        std::vector<uint8_t> Data;
+        bool Last = false;
+    };
+
+    // Fills buffers from a file descriptor on a separate thread, so that reading overlaps with transcoding.
+    // Buffers are taken from `free` and passed on through `full`, which is closed after the last.  Read
+    // errors are recorded and end the input.
+    inline void read_buffers(int fd, Channel<Buffer>& free, Channel<Buffer>& full, std::exception_ptr& error) {
+        try {
+            while (auto buffer = free.Pop()) {
+                buffer->Data.resize(ChunkSize);
+                size_t length = read_full(fd, buffer->Data.data(), ChunkSize);
+                buffer->Data.resize(length);
+                buffer->Last = (length < ChunkSize);
+
+                bool last = buffer->Last;
+                full.Push(std::move(*buffer));
+                if (last) {
+                    break;
+                }
+            }
+        } catch (...) {
+            error = std::current_exception();
+            full.Push(Buffer{ {}, true });
+        }
+        full.Close();
+    }
+
+    // Writes buffers to a file descriptor on a separate thread, returning each to `free` once written.
+    // After an error, the remaining buffers are discarded.
+    inline void write_buffers(int fd, Channel<Buffer>& full, Channel<Buffer>& free, std::exception_ptr& error) {
+        while (auto buffer = full.Pop()) {
+            if (!error) {
+                try {
+                    write_full(fd, buffer->Data.data(), buffer->Data.size());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            buffer->Data.clear();
+            free.Push(std::move(*buffer));
+        }
+    }
+
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Base64.hpp"
+
+namespace cli {
+
+    // Binary bytes encoded at a time before wrapping, so that the unwrapped output stays in L1/L2.
+    constexpr size_t EncodeBlockSize = 3 * 16 * 1024;
+
+    // Encodes a stream of chunks, wrapping lines at a fixed width.  Every chunk except the last must be a
+    // multiple of three bytes long.
+    class Encoder {
+    public:
+        Encoder(size_t wrap, bool url)
+          : m_wrap(wrap)
+          , m_url(url)
+        {}
+
+        // Appends the encoding of `data` to `output`.
+        void Encode(const uint8_t* data, size_t length, bool last, std::vector<uint8_t>& output) {
+            for (size_t offset = 0; offset < length; offset += EncodeBlockSize) {
+                size_t block_length = std::min(EncodeBlockSize, length - offset);
+                size_t encoded_length = base64::get_encoded_length(block_length);
+
+                if (m_wrap == 0) {
+                    size_t start = output.size();
+                    output.resize(start + encoded_length);
+                    base64::encode(data + offset, block_length, output.data() + start, encoded_length);
+                    Translate(output.data() + start, encoded_length);
+                } else {
+                    m_block.resize(encoded_length);
+                    base64::encode(data + offset, block_length, m_block.data(), encoded_length);
+                    Translate(m_block.data(), encoded_length);
+                    Wrap(m_block.data(), encoded_length, output);
+                }
+            }
+
+            // Like coreutils, wrapped output ends with a line break.
+            if (last && m_wrap != 0 && m_column != 0) {
+                output.push_back('\n');
+                m_column = 0;
+            }
+        }
+
+    private:
+        size_t m_wrap;
+        bool m_url;
+        size_t m_column = 0;
+        std::vector<uint8_t> m_block;
+
+        // Converts the standard alphabet to the URL and filename safe alphabet of RFC 4648.
+        void Translate(uint8_t* data, size_t length) const {
+            if (!m_url) {
+                return;
+            }
+            for (size_t i = 0; i < length; ++i) {
+                uint8_t c = data[i];
+                data[i] = (c == '+') ? '-' : (c == '/') ? '_' : c;
+            }
+        }
+
+        void Wrap(const uint8_t* data, size_t length, std::vector<uint8_t>& output) {
+            size_t start = output.size();
+            output.resize(start + length + length / m_wrap + 1);
+            uint8_t* dest = output.data() + start;
+
+            size_t offset = 0;
+            while (offset < length) {
+                size_t line = std::min(m_wrap - m_column, length - offset);
+                std::memcpy(dest, data + offset, line);
+                dest += line;
+                offset += line;
+                m_column += line;
+
+                if (m_column == m_wrap) {
+                    *dest++ = '\n';
+                    m_column = 0;
+                }
+            }
+
+            output.resize(static_cast<size_t>(dest - output.data()));
+        }
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Decodes a stream of chunks of any length.  Line breaks are skipped and, when ignoring garbage, so is
+    // anything else outside the alphabet; otherwise invalid input throws.  As with coreutils, each group of
+    // four characters may end with one or two '=', after which a new group starts, and the input must end
+    // with a whole group.
+    class Decoder {
+    public:
+        Decoder(bool ignore_garbage, bool url)
+          : m_ignore_garbage(ignore_garbage)
+        {
+            m_classes.fill(Garbage);
+            for (uint8_t c : base64::detail::Base64LUT) {
+                m_classes[c] = Alphabet;
+            }
+            if (url) {
+                m_classes['+'] = Garbage;
+                m_classes['/'] = Garbage;
+                m_classes['-'] = Alphabet;
+                m_classes['_'] = Alphabet;
+            }
+            m_classes['\n'] = LineBreak;
+            m_classes['='] = Padding;
+
+            for (size_t c = 0; c < m_translation.size(); ++c) {
+                m_translation[c] = static_cast<uint8_t>(c);
+            }
+            if (url) {
+                m_translation['-'] = '+';
+                m_translation['_'] = '/';
+            }
+        }
+
+        // Appends the decoding of all complete groups in `data` to `output`, keeping any partial group for
+        // the next chunk.
+        void Decode(const uint8_t* data, size_t length, std::vector<uint8_t>& output) {
+            Filter(data, length, output);
+
+            size_t group_length = (m_clean.size() / 4) * 4;
+            Append(m_clean.data(), group_length, output);
+            m_clean.erase(m_clean.begin(), m_clean.begin() + static_cast<std::ptrdiff_t>(group_length));
+        }
+
+        // Checks that the input ended with a whole group.
+        void Finish(std::vector<uint8_t>& output) {
+            if (!m_clean.empty() || m_padding != 0) {
+                Fail(m_clean.size(), output);
+            }
+        }
+
+    private:
+        enum Class : uint8_t {
+            Alphabet = 0,
+            LineBreak = 1,
+            Padding = 2,
+            Garbage = 4
+        };
+
+        bool m_ignore_garbage;
+        // The number of '=' so far in the current group.
+        size_t m_padding = 0;
+        std::array<uint8_t, 256> m_classes;
+        std::array<uint8_t, 256> m_translation;
+        std::vector<uint8_t> m_clean;
+
+        // Appends the alphabet characters of `data` to `m_clean`, translated to the standard alphabet.  Each
+        // padded group is decoded to `output` as soon as it's complete, leaving `m_clean` empty.
+        void Filter(const uint8_t* data, size_t length, std::vector<uint8_t>& output) {
+            size_t start = m_clean.size();
+            m_clean.resize(start + length);
+            uint8_t* dest = m_clean.data() + start;
+
+            // Fast path: copy whole lines and check them in one branch-free pass.
+            const uint8_t* begin = data;
+            const uint8_t* end = data + length;
+            uint8_t classes = 0;
+            while (data < end) {
+                auto line_end = static_cast<const uint8_t*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+                if (!line_end) {
+                    line_end = end;
+                }
+                size_t line = static_cast<size_t>(line_end - data);
+                for (size_t i = 0; i < line; ++i) {
+                    classes |= m_classes[data[i]];
+                    dest[i] = m_translation[data[i]];
+                }
+                dest += line;
+                data = line_end + (line_end < end ? 1 : 0);
+            }
+
+            if (classes != Alphabet || m_padding != 0) {
+                // Slow path: padding or garbage somewhere in the chunk.  Filter it again one character at a
+                // time.
+                dest = m_clean.data() + start;
+                for (data = begin; data < end; ++data) {
+                    switch (m_classes[*data]) {
+                    case Alphabet:
+                        if (m_padding != 0) {
+                            Fail(static_cast<size_t>(dest - m_clean.data()), output);
+                        }
+                        *dest++ = m_translation[*data];
+                        break;
+                    case LineBreak:
+                        break;
+                    case Padding: {
+                        // Padding may only fill the last one or two characters of a group.
+                        size_t clean_length = static_cast<size_t>(dest - m_clean.data());
+                        size_t position = (clean_length + m_padding) % 4;
+                        if (position < 2) {
+                            Fail(clean_length, output);
+                        }
+                        if (position == 3) {
+                            Append(m_clean.data(), clean_length, output);
+                            dest = m_clean.data();
+                            m_padding = 0;
+                        } else {
+                            ++m_padding;
+                        }
+                        break;
+                    }
+                    default:
+                        if (!m_ignore_garbage) {
+                            Fail(static_cast<size_t>(dest - m_clean.data()), output);
+                        }
+                        break;
+                    }
+                }
+            }
+
+            m_clean.resize(static_cast<size_t>(dest - m_clean.data()));
+        }
+
+        // Like coreutils, decodes as much as possible of the first `clean_length` characters of `m_clean`
+        // before reporting invalid input.
+        [[noreturn]] void Fail(size_t clean_length, std::vector<uint8_t>& output) {
+            if (clean_length % 4 == 1) {
+                --clean_length;
+            }
+            Append(m_clean.data(), clean_length, output);
+            m_clean.clear();
+            throw std::runtime_error("invalid input");
+        }
+
+        static void Append(const uint8_t* data, size_t length, std::vector<uint8_t>& output) {
+            size_t decoded_length = base64::get_decoded_length(data, length);
+            size_t start = output.size();
+            output.resize(start + decoded_length);
+            base64::decode(data, length, output.data() + start, decoded_length);
+        }
+    };
+
+}
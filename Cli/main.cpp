@@ -0,0 +1,233 @@
+#include "Io.hpp"
+#include "Transcoder.hpp"
+
+#include <cstring>
+#include <exception>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+    struct Options {
+        bool Decode = false;
+        bool IgnoreGarbage = false;
+        bool Url = false;
+        size_t Wrap = 76;
+        std::string Path = "-";
+    };
+
+    //--------------------------------------------------------------------------------------------------------
+
+    void print_usage() {
+        std::cout
+            << "Usage: cppbase64 [<options>] [<file>]\n"
+            << "Base64 encode or decode <file>, or standard input, to standard output.\n"
+            << "With no <file>, or when <file> is -, read standard input.\n"
+            << "\n"
+            << "    -d, --decode:           Decode data\n"
+            << "    -i, --ignore-garbage:   When decoding, ignore non-alphabet characters\n"
+            << "    -w, --wrap=<cols>:      Wrap encoded lines after <cols> characters (default 76).  Use 0 to\n"
+            << "                            disable line wrapping\n"
+            << "    -u, --url, --base64url: Use the URL and filename safe alphabet (RFC 4648 section 5)\n"
+            << "    -h, --help:             Displays this message\n";
+    }
+
+    size_t parse_wrap(const std::string& text) {
+        size_t end = 0;
+        size_t value = 0;
+        try {
+            value = std::stoull(text, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size() || text[0] == '-') {
+            throw std::invalid_argument("invalid wrap size: '" + text + "'");
+        }
+        return value;
+    }
+
+    // Parses coreutils style options, including combined short options such as -di and -w0.
+    bool parse_options(int argc, const char* argv[], Options& options) {
+        bool have_path = false;
+        for (int index = 1; index < argc; ++index) {
+            std::string arg = argv[index];
+
+            auto next_value = [&]() -> std::string {
+                if (index + 1 >= argc) {
+                    throw std::invalid_argument("option requires an argument -- '" + arg + "'");
+                }
+                return argv[++index];
+            };
+
+            if (arg == "-h" || arg == "--help") {
+                print_usage();
+                return false;
+            } else if (arg == "--decode") {
+                options.Decode = true;
+            } else if (arg == "--ignore-garbage") {
+                options.IgnoreGarbage = true;
+            } else if (arg == "--url" || arg == "--base64url") {
+                options.Url = true;
+            } else if (arg == "--wrap") {
+                options.Wrap = parse_wrap(next_value());
+            } else if (arg.rfind("--wrap=", 0) == 0) {
+                options.Wrap = parse_wrap(arg.substr(7));
+            } else if (arg.size() > 1 && arg[0] == '-' && arg[1] != '-') {
+                for (size_t i = 1; i < arg.size(); ++i) {
+                    switch (arg[i]) {
+                    case 'd': options.Decode = true; break;
+                    case 'i': options.IgnoreGarbage = true; break;
+                    case 'u': options.Url = true; break;
+                    case 'w':
+                        options.Wrap = parse_wrap(i + 1 < arg.size() ? arg.substr(i + 1) : next_value());
+                        i = arg.size();
+                        break;
+                    default:
+                        throw std::invalid_argument(std::string("invalid option -- '") + arg[i] + "'");
+                    }
+                }
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                throw std::invalid_argument("unrecognized option '" + arg + "'");
+            } else if (have_path) {
+                throw std::invalid_argument("extra operand '" + arg + "'");
+            } else {
+                options.Path = arg;
+                have_path = true;
+            }
+        }
+        return true;
+    }
+
+    //--------------------------------------------------------------------------------------------------------
+
+    // Encodes or decodes the input, chunk by chunk, into buffers written by a separate thread.  Regular
+    // files are memory-mapped and transcoded in place; anything else is read by a separate thread.
+    void run(const Options& options, int input_fd) {
+        cli::Encoder encoder(options.Wrap, options.Url);
+        cli::Decoder decoder(options.IgnoreGarbage, options.Url);
+
+        cli::Channel<cli::Buffer> free_output;
+        cli::Channel<cli::Buffer> full_output;
+        for (size_t i = 0; i < cli::BufferCount; ++i) {
+            free_output.Push(cli::Buffer{});
+        }
+
+        std::exception_ptr write_error;
+        std::thread writer(cli::write_buffers, STDOUT_FILENO, std::ref(full_output), std::ref(free_output), std::ref(write_error));
+
+        // On invalid input, the output decoded before it is still written.
+        auto transcode = [&](const uint8_t* data, size_t length, bool last) {
+            auto output = free_output.Pop();
+            try {
+                if (options.Decode) {
+                    decoder.Decode(data, length, output->Data);
+                    if (last) {
+                        decoder.Finish(output->Data);
+                    }
+                } else {
+                    encoder.Encode(data, length, last, output->Data);
+                }
+            } catch (...) {
+                full_output.Push(std::move(*output));
+                throw;
+            }
+            full_output.Push(std::move(*output));
+        };
+
+        std::exception_ptr error;
+        std::exception_ptr read_error;
+
+        struct stat info;
+        if (::fstat(input_fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            size_t length = static_cast<size_t>(info.st_size);
+            void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, input_fd, 0);
+            if (mapping == MAP_FAILED) {
+                error = std::make_exception_ptr(std::system_error(errno, std::generic_category(), "mmap failed"));
+            } else {
+                ::madvise(mapping, length, MADV_SEQUENTIAL);
+                try {
+                    auto data = static_cast<const uint8_t*>(mapping);
+                    for (size_t offset = 0; offset < length; offset += cli::ChunkSize) {
+                        size_t chunk = std::min(cli::ChunkSize, length - offset);
+                        transcode(data + offset, chunk, offset + chunk == length);
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                ::munmap(mapping, length);
+            }
+        } else {
+            cli::Channel<cli::Buffer> free_input;
+            cli::Channel<cli::Buffer> full_input;
+            for (size_t i = 0; i < cli::BufferCount; ++i) {
+                free_input.Push(cli::Buffer{});
+            }
+
+            std::thread reader(cli::read_buffers, input_fd, std::ref(free_input), std::ref(full_input), std::ref(read_error));
+            try {
+                while (auto input = full_input.Pop()) {
+                    bool last = input->Last;
+                    transcode(input->Data.data(), input->Data.size(), last);
+                    free_input.Push(std::move(*input));
+                    if (last) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            free_input.Close();
+            reader.join();
+        }
+
+        full_output.Close();
+        writer.join();
+
+        for (auto& exception : { read_error, error, write_error }) {
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[]) {
+    try {
+        Options options;
+        if (!parse_options(argc, argv, options)) {
+            return 0;
+        }
+
+        int input_fd = STDIN_FILENO;
+        if (options.Path != "-") {
+            input_fd = ::open(options.Path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (input_fd < 0) {
+                throw std::runtime_error(options.Path + ": " + std::strerror(errno));
+            }
+        }
+
+        run(options, input_fd);
+
+        if (input_fd != STDIN_FILENO) {
+            ::close(input_fd);
+        }
+        return 0;
+
+    } catch (const std::invalid_argument& ex) {
+        std::cerr << "cppbase64: " << ex.what() << "\nTry 'cppbase64 --help' for more information." << std::endl;
+        return 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "cppbase64: " << ex.what() << std::endl;
+        return 1;
+    }
+}
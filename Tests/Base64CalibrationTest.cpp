@@ -0,0 +1,101 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64Calibration.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+    struct Base64CalibrationTest {
+        Base64CalibrationTest()
+          : m_original(base64::get_dispatch_table())
+        {}
+
+        ~Base64CalibrationTest() {
+            base64::set_dispatch_table(m_original);
+        }
+
+        static bool IsSupported(const base64::DispatchTable& table) {
+            for (size_t i = 0; i < base64::SizeClassCount; ++i) {
+                if (table.encode[i] == base64::Codepath::Auto || !base64::is_codepath_supported(table.encode[i])) {
+                    return false;
+                }
+                if (table.decode[i] == base64::Codepath::Auto || !base64::is_codepath_supported(table.decode[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static bool AreEqual(const base64::DispatchTable& left, const base64::DispatchTable& right) {
+            return left.size_limits == right.size_limits &&
+                left.encode == right.encode &&
+                left.decode == right.decode;
+        }
+
+    private:
+        base64::DispatchTable m_original;
+    };
+}
+
+namespace base64calibration_test {
+
+    TEST_CASE(Base64CalibrationTest, Calibrate) {
+        using namespace std::chrono;
+
+        auto start = steady_clock::now();
+        auto table = base64::calibrate();
+        duration<double, std::milli> elapsed = steady_clock::now() - start;
+
+        CHECK(IsSupported(table));
+        CHECK(table.encode[0] == base64::Codepath::Basic);
+        CHECK(table.decode[0] == base64::Codepath::Basic);
+        CHECK(table.size_limits == base64::get_dispatch_table().size_limits);
+        CHECK(elapsed.count() < 1000.0);
+        CHECK_NO_THROW(base64::set_dispatch_table(table));
+    }
+
+    TEST_CASE(Base64CalibrationTest, ExportImport) {
+        SECTION("Round trip") {
+            auto table = base64::make_default_dispatch_table();
+            table.size_limits = { 16, 256, 4096 };
+            table.encode[1] = base64::Codepath::Basic;
+
+            auto imported = base64::import_dispatch_table(base64::export_dispatch_table(table));
+            REQUIRE(imported.has_value());
+            CHECK(AreEqual(*imported, table));
+        }
+
+        SECTION("Rejects invalid data") {
+            CHECK_FALSE(base64::import_dispatch_table("").has_value());
+            CHECK_FALSE(base64::import_dispatch_table("not a dispatch table").has_value());
+            CHECK_FALSE(base64::import_dispatch_table("cppbase64-dispatch-1 0 24 512 65536 1 1 1 1 1 1 1 1").has_value());
+
+            auto blob = base64::export_dispatch_table(base64::make_default_dispatch_table());
+            CHECK_FALSE(base64::import_dispatch_table(blob.substr(0, blob.size() - 2)).has_value());
+
+            if (base64::is_codepath_supported(base64::Codepath::SSSE3)) {
+                auto table = base64::make_default_dispatch_table();
+                table.encode[0] = base64::Codepath::SSSE3;
+                CHECK_FALSE(base64::import_dispatch_table(base64::export_dispatch_table(table)).has_value());
+            }
+        }
+
+        SECTION("File") {
+            auto path = (std::filesystem::temp_directory_path() / "cppbase64_calibration_test.txt").string();
+            std::remove(path.c_str());
+
+            CHECK_FALSE(base64::load_dispatch_table(path).has_value());
+
+            auto table = base64::load_or_calibrate(path);
+            auto loaded = base64::load_dispatch_table(path);
+            REQUIRE(loaded.has_value());
+            CHECK(AreEqual(*loaded, table));
+            CHECK(AreEqual(base64::get_dispatch_table(), table));
+
+            std::remove(path.c_str());
+        }
+    }
+
+}
@@ -0,0 +1,147 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64Checksum.hpp"
+
+namespace {
+
+    struct Base64ChecksumTest {
+        static uint32_t GetCrc32c(const std::vector<uint8_t>& data) {
+            base64::Crc32c crc;
+            crc.Update(data.data(), data.size());
+            return crc.GetValue();
+        }
+
+        static bool TestEncode(size_t length, size_t block_size, bool padded) {
+            auto source = test_data::MakeBinary(length);
+            auto expected = base64::encode_to_byte_vector(source.data(), length, padded);
+
+            base64::PipelineOptions options;
+            options.block_size = block_size;
+            options.padded = padded;
+
+            std::vector<uint8_t> dest(expected.size());
+            uint32_t crc = base64::encode_crc32c(source.data(), length, dest.data(), dest.size(), options);
+            return dest == expected && crc == GetCrc32c(source);
+        }
+
+        static bool TestDecode(size_t length, size_t block_size, bool padded) {
+            auto expected = test_data::MakeBinary(length);
+            auto source = base64::encode_to_byte_vector(expected.data(), length, padded);
+
+            base64::PipelineOptions options;
+            options.block_size = block_size;
+
+            std::vector<uint8_t> dest(length);
+            uint32_t crc = base64::decode_crc32c(source.data(), source.size(), dest.data(), dest.size(), options);
+            return dest == expected && crc == GetCrc32c(expected);
+        }
+    };
+}
+
+namespace base64checksum_test {
+
+    TEST_CASE(Base64ChecksumTest, Crc32c) {
+        SECTION("Known values") {
+            const std::string check = "123456789";
+            base64::Crc32c crc;
+            CHECK(crc.GetValue() == 0);
+            crc.Update(reinterpret_cast<const uint8_t*>(check.data()), check.size());
+            CHECK(crc.GetValue() == 0xe3069283);
+
+            CHECK(GetCrc32c(std::vector<uint8_t>(32, 0)) == 0x8a9136aa);
+            CHECK(GetCrc32c(std::vector<uint8_t>(32, 0xff)) == 0x62a8ab43);
+        }
+
+        SECTION("Incremental") {
+            // Any split gives the same result, and the hardware and table versions agree.
+            auto source = test_data::MakeBinary(1000);
+            uint32_t expected = GetCrc32c(source);
+            for (size_t split : { 0, 1, 7, 8, 9, 500, 999 }) {
+                base64::Crc32c crc;
+                crc.Update(source.data(), split);
+                crc.Update(source.data() + split, source.size() - split);
+                CHECK(crc.GetValue() == expected);
+            }
+            CHECK(~base64::detail::update_crc32c_basic(0xffffffff, source.data(), source.size()) == expected);
+        }
+
+        SECTION("Hardware lanes") {
+            // From three lanes' worth of data, the hardware version checksums lanes in parallel and combines
+            // them, which must agree with the table version.
+            if (!base64::detail::use_sse42_crc32c()) {
+                return;
+            }
+            auto source = test_data::MakeBinary(100003);
+            for (size_t length : { 3071, 3072, 3073, 3080, 6144, 6145, 100003 }) {
+                for (size_t offset : { 0, 1 }) {
+                    uint32_t hardware = base64::detail::update_crc32c_sse42(0x12345678, source.data() + offset, length - offset);
+                    uint32_t table = base64::detail::update_crc32c_basic(0x12345678, source.data() + offset, length - offset);
+                    CHECK(hardware == table);
+                }
+            }
+        }
+    }
+
+    TEST_CASE(Base64ChecksumTest, Encode) {
+        SECTION("Small blocks") {
+            for (size_t length = 0; length < 200; ++length) {
+                CHECK(TestEncode(length, 1, true));
+                CHECK(TestEncode(length, 48, false));
+            }
+        }
+
+        SECTION("Large buffers") {
+            CHECK(TestEncode(1000000, 64 * 1024, true));
+            CHECK(TestEncode(1000001, 100000, false));
+        }
+
+        SECTION("Generic checksum") {
+            // A callback sees each chunk of the source, in order.
+            auto source = test_data::MakeBinary(100000);
+            std::vector<uint8_t> dest(base64::get_encoded_length(source.size()));
+            std::vector<uint8_t> seen;
+            base64::encode_checksummed(source.data(), source.size(), dest.data(), dest.size(), [&](const uint8_t* data, size_t length) {
+                seen.insert(seen.end(), data, data + length);
+            });
+            CHECK(seen == source);
+        }
+
+        SECTION("Incorrect dest size") {
+            auto source = test_data::MakeBinary(10);
+            std::vector<uint8_t> dest(base64::get_encoded_length(source.size()) + 1);
+            CHECK_THROW(std::logic_error, base64::encode_crc32c(source.data(), source.size(), dest.data(), dest.size()));
+        }
+    }
+
+    TEST_CASE(Base64ChecksumTest, Decode) {
+        SECTION("Small blocks") {
+            for (size_t length = 0; length < 200; ++length) {
+                CHECK(TestDecode(length, 1, true));
+                CHECK(TestDecode(length, 64, false));
+            }
+        }
+
+        SECTION("Large buffers") {
+            CHECK(TestDecode(1000000, 64 * 1024, true));
+            CHECK(TestDecode(1000001, 100000, false));
+        }
+
+        SECTION("Generic checksum") {
+            auto expected = test_data::MakeBinary(100000);
+            auto source = base64::encode_to_byte_vector(expected.data(), expected.size());
+            std::vector<uint8_t> dest(expected.size());
+            std::vector<uint8_t> seen;
+            base64::decode_checksummed(source.data(), source.size(), dest.data(), dest.size(), [&](const uint8_t* data, size_t length) {
+                seen.insert(seen.end(), data, data + length);
+            });
+            CHECK(seen == expected);
+        }
+
+        SECTION("Incorrect dest size") {
+            auto source = base64::encode_to_byte_vector(test_data::MakeBinary(10).data(), 10);
+            std::vector<uint8_t> dest(9);
+            CHECK_THROW(std::logic_error, base64::decode_crc32c(source.data(), source.size(), dest.data(), dest.size()));
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#ifdef CPPBASE64_PATH
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+    // Runs the cppbase64 executable and compares it with the known output of coreutils base64 and basenc.
+    struct Base64CliTest {
+        struct Result {
+            int status = -1;
+            std::string output;
+
+            bool operator==(const Result& other) const {
+                return status == other.status && output == other.output;
+            }
+        };
+
+        Base64CliTest()
+          : m_directory(std::filesystem::temp_directory_path() / ("base64_cli_test_" + std::to_string(::getpid())))
+        {
+            std::filesystem::create_directories(m_directory);
+        }
+
+        ~Base64CliTest() {
+            std::error_code error;
+            std::filesystem::remove_all(m_directory, error);
+        }
+
+        // Runs the tool with `input` both from a pipe and from a file, which it reads differently, and
+        // returns the exit status and standard output if they agree.
+        Result RunTool(const std::string& arguments, const std::string& input) const {
+            std::string input_path = (m_directory / "input").string();
+            std::string output_path = (m_directory / "output").string();
+            {
+                std::ofstream file(input_path, std::ios::binary | std::ios::trunc);
+                file << input;
+            }
+
+            std::string command = std::string("\"") + CPPBASE64_PATH + "\" " + arguments;
+            Result piped = Execute("cat \"" + input_path + "\" | " + command + " > \"" + output_path + "\" 2>/dev/null", output_path);
+            Result mapped = Execute(command + " \"" + input_path + "\" > \"" + output_path + "\" 2>/dev/null", output_path);
+            return (piped == mapped) ? piped : Result{};
+        }
+
+        static Result Ok(const std::string& output) {
+            return Result{ 0, output };
+        }
+
+        // Like coreutils, the output decoded before invalid input is still written.
+        static Result Invalid(const std::string& output = {}) {
+            return Result{ 1, output };
+        }
+
+    private:
+        std::filesystem::path m_directory;
+
+        static Result Execute(const std::string& command, const std::string& output_path) {
+            Result result;
+            int status = std::system(command.c_str());
+            result.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+            std::ifstream file(output_path, std::ios::binary);
+            result.output.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return result;
+        }
+    };
+}
+
+namespace base64cli_test {
+
+    TEST_CASE(Base64CliTest, Encode) {
+        SECTION("Wrapping") {
+            std::string text(60, 'x');
+            std::string encoded = "eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4eHh4";
+            CHECK(RunTool("", text) == Ok(encoded.substr(0, 76) + "\n" + encoded.substr(76) + "\n"));
+            CHECK(RunTool("-w0", text) == Ok(encoded));
+            CHECK(RunTool("-w 30", text) == Ok(encoded.substr(0, 30) + "\n" + encoded.substr(30, 30) + "\n" + encoded.substr(60) + "\n"));
+            CHECK(RunTool("--wrap=40", text) == Ok(encoded.substr(0, 40) + "\n" + encoded.substr(40) + "\n"));
+            CHECK(RunTool("-w4", "foobar") == Ok("Zm9v\nYmFy\n"));
+            CHECK(RunTool("", "") == Ok(""));
+            CHECK(RunTool("-w", "foo").status == 1);
+            CHECK(RunTool("-w-1", "foo").status == 1);
+        }
+
+        SECTION("URL alphabet") {
+            CHECK(RunTool("", "\xfb\xff\xbf") == Ok("+/+/\n"));
+            CHECK(RunTool("-u", "\xfb\xff\xbf") == Ok("-_-_\n"));
+            CHECK(RunTool("--base64url -w0", "\xfb\xff") == Ok("-_8="));
+        }
+    }
+
+    TEST_CASE(Base64CliTest, Decode) {
+        SECTION("Valid") {
+            CHECK(RunTool("-d", "Zm9vYmFy") == Ok("foobar"));
+            CHECK(RunTool("-d", "Zm9v\nYmFy\n") == Ok("foobar"));
+            CHECK(RunTool("-d", "Zg==") == Ok("f"));
+            CHECK(RunTool("-d", "Zm8=\n") == Ok("fo"));
+            CHECK(RunTool("--decode", "") == Ok(""));
+        }
+
+        SECTION("Padding") {
+            // Padding closes a group, and a new group may follow.
+            CHECK(RunTool("-d", "Zm8=Zm8=") == Ok("fofo"));
+            CHECK(RunTool("-d", "Zg==\nZm8=\nZm9v") == Ok("ffofoo"));
+            CHECK(RunTool("-d", "Zm9v=") == Invalid("foo"));
+            CHECK(RunTool("-d", "====") == Invalid());
+            CHECK(RunTool("-d", "Zg=") == Invalid("f"));
+            CHECK(RunTool("-d", "Zg===") == Invalid("f"));
+            CHECK(RunTool("-d", "Zg=a") == Invalid("f"));
+        }
+
+        SECTION("Partial final group") {
+            CHECK(RunTool("-d", "Zm8") == Invalid("fo"));
+            CHECK(RunTool("-d", "Zm9vYg") == Invalid("foob"));
+            CHECK(RunTool("-d", "Zg==Zg") == Invalid("ff"));
+            CHECK(RunTool("-d", "Z") == Invalid());
+            CHECK(RunTool("-di", "Zm8") == Invalid("fo"));
+        }
+
+        SECTION("Garbage") {
+            CHECK(RunTool("-d", "Zm*8=") == Invalid("f"));
+            CHECK(RunTool("-d", "Zm9v\r\n") == Invalid("foo"));
+            CHECK(RunTool("-di", "Zm*8=") == Ok("fo"));
+            CHECK(RunTool("-di", "Zg=!=") == Ok("f"));
+            CHECK(RunTool("--ignore-garbage -d", "Zm9v\r\nYmFy\r\n") == Ok("foobar"));
+        }
+
+        SECTION("URL alphabet") {
+            CHECK(RunTool("-du", "-_-_") == Ok("\xfb\xff\xbf"));
+            CHECK(RunTool("-du", "+/+/") == Invalid());
+            CHECK(RunTool("-d", "-_-_") == Invalid());
+            CHECK(RunTool("-diu", "+-_-_/") == Ok("\xfb\xff\xbf"));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64Columns.hpp"
+
+namespace {
+
+    struct Base64ColumnsTest {
+        static base64::BinaryColumn MakeColumn(size_t count) {
+            base64::BinaryColumn column;
+            for (size_t i = 0; i < count; ++i) {
+                size_t length = (i * 7) % 50;
+                for (size_t j = 0; j < length; ++j) {
+                    column.data.push_back(static_cast<uint8_t>(i * 17 + j * 3));
+                }
+                column.offsets.push_back(column.data.size());
+            }
+            return column;
+        }
+
+        static std::vector<uint8_t> GetValue(const base64::BinaryColumn& column, size_t i) {
+            return std::vector<uint8_t>(
+                column.data.begin() + static_cast<std::ptrdiff_t>(column.offsets[i]),
+                column.data.begin() + static_cast<std::ptrdiff_t>(column.offsets[i + 1])
+            );
+        }
+
+        // Checks that each value of `encoded` is the encoding of the same value of `column`.
+        static bool IsEncoding(const base64::BinaryColumn& encoded, const base64::BinaryColumn& column, bool padded) {
+            if (encoded.size() != column.size() || encoded.offsets.front() != 0 || encoded.offsets.back() != encoded.data.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < column.size(); ++i) {
+                auto value = GetValue(column, i);
+                if (GetValue(encoded, i) != base64::encode_to_byte_vector(value.data(), value.size(), padded)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+namespace base64columns_test {
+
+    TEST_CASE(Base64ColumnsTest, Column) {
+        SECTION("Round trip") {
+            auto column = MakeColumn(500);
+            for (bool padded : { true, false }) {
+                base64::ColumnOptions options;
+                options.padded = padded;
+                auto encoded = base64::encode_column(column, options);
+                CHECK(IsEncoding(encoded, column, padded));
+
+                auto decoded = base64::decode_column(encoded, options);
+                CHECK(decoded.data == column.data);
+                CHECK(decoded.offsets == column.offsets);
+            }
+        }
+
+        SECTION("Empty column") {
+            base64::BinaryColumn column;
+            CHECK(base64::encode_column(column).size() == 0);
+            CHECK(base64::decode_column(column).size() == 0);
+        }
+
+        SECTION("Slice") {
+            // Offsets of a slice start part way through the data.
+            auto column = MakeColumn(100);
+            base64::BinaryColumn slice;
+            slice.offsets.assign(column.offsets.begin() + 10, column.offsets.begin() + 21);
+            slice.data.assign(column.data.begin() + static_cast<std::ptrdiff_t>(slice.offsets.front()), column.data.begin() + static_cast<std::ptrdiff_t>(slice.offsets.back()));
+            for (auto& offset : slice.offsets) {
+                offset -= column.offsets[10];
+            }
+
+            base64::BinaryColumn encoded;
+            base64::encode_column(column.data.data(), column.offsets.data() + 10, 10, encoded);
+            CHECK(IsEncoding(encoded, slice, true));
+        }
+
+        SECTION("Multiple threads") {
+            auto column = MakeColumn(20000);
+            base64::ColumnOptions options;
+            options.min_bytes_per_thread = 1000;
+            for (size_t threads : { 2, 3, 8 }) {
+                options.threads = threads;
+                auto encoded = base64::encode_column(column, options);
+                CHECK(IsEncoding(encoded, column, true));
+                CHECK(base64::decode_column(encoded, options).data == column.data);
+            }
+        }
+
+        SECTION("Reused result") {
+            base64::BinaryColumn result;
+            base64::encode_column(MakeColumn(1000), {}).data.swap(result.data);
+            auto column = MakeColumn(10);
+            base64::encode_column(column.data.data(), column.offsets.data(), column.size(), result);
+            CHECK(IsEncoding(result, column, true));
+        }
+    }
+}
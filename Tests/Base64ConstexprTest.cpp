@@ -0,0 +1,100 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64.hpp"
+
+namespace {
+
+    struct Base64ConstexprTest {
+        template <size_t EncodedLength, size_t N>
+        static constexpr std::array<uint8_t, EncodedLength> Encode(const char (&str)[N], bool padded) {
+            std::array<uint8_t, N - 1> source{};
+            for (size_t i = 0; i < N - 1; ++i) {
+                source[i] = static_cast<uint8_t>(str[i]);
+            }
+
+            std::array<uint8_t, EncodedLength> result{};
+            base64::encode(source.data(), source.size(), result.data(), result.size(), padded);
+            return result;
+        }
+
+        template <size_t DecodedLength, size_t N>
+        static constexpr std::array<uint8_t, DecodedLength> Decode(const char (&str)[N]) {
+            std::array<uint8_t, N - 1> source{};
+            for (size_t i = 0; i < N - 1; ++i) {
+                source[i] = static_cast<uint8_t>(str[i]);
+            }
+
+            std::array<uint8_t, DecodedLength> result{};
+            base64::decode(source.data(), source.size(), result.data(), result.size());
+            return result;
+        }
+
+        template <size_t N>
+        static constexpr bool Equals(const std::array<uint8_t, N>& left, const char* right) {
+            for (size_t i = 0; i < N; ++i) {
+                if (left[i] != static_cast<uint8_t>(right[i])) {
+                    return false;
+                }
+            }
+            return right[N] == '\0';
+        }
+
+        template <size_t N>
+        static constexpr bool Equals(const std::array<char, N>& left, const char* right) {
+            for (size_t i = 0; i < N; ++i) {
+                if (left[i] != right[i]) {
+                    return false;
+                }
+            }
+            return right[N] == '\0';
+        }
+    };
+}
+
+namespace base64constexpr_test {
+
+    TEST_CASE(Base64ConstexprTest, Encode) {
+        static_assert(Equals(Encode<4>("f", true), "Zg=="));
+        static_assert(Equals(Encode<4>("fo", true), "Zm8="));
+        static_assert(Equals(Encode<8>("foobar", true), "Zm9vYmFy"));
+        static_assert(Equals(Encode<2>("f", false), "Zg"));
+        static_assert(Equals(Encode<7>("fooba", false), "Zm9vYmE"));
+
+        constexpr std::array<uint8_t, 3> source = { 'f', 'o', 'o' };
+        static_assert(Equals(base64::encode_fixed(source), "Zm9v"));
+
+        CHECK(Equals(Encode<8>("foobar", true), "Zm9vYmFy"));
+    }
+
+    TEST_CASE(Base64ConstexprTest, Decode) {
+        static_assert(Equals(Decode<1>("Zg=="), "f"));
+        static_assert(Equals(Decode<2>("Zm8"), "fo"));
+        static_assert(Equals(Decode<6>("Zm9vYmFy"), "foobar"));
+        static_assert(base64::get_decoded_length(Encode<8>("foob", true).data(), 8) == 4);
+
+        constexpr std::array<uint8_t, 4> source = { 'Z', 'm', '9', 'v' };
+        static_assert(Equals(base64::decode_fixed<3>(source.data()), "foo"));
+
+        CHECK(Equals(Decode<6>("Zm9vYmFy"), "foobar"));
+    }
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L) && defined(__cpp_consteval)
+    TEST_CASE(Base64ConstexprTest, Literals) {
+        using namespace base64::literals;
+
+        constexpr auto encoded = "foobar"_b64;
+        static_assert(std::is_same_v<decltype(encoded), const std::array<char, 8>>);
+        static_assert(Equals(encoded, "Zm9vYmFy"));
+        static_assert(Equals("fooba"_b64, "Zm9vYmE="));
+        static_assert(Equals(""_b64, ""));
+
+        constexpr auto decoded = "Zm9vYmE="_unb64;
+        static_assert(std::is_same_v<decltype(decoded), const std::array<uint8_t, 5>>);
+        static_assert(Equals(decoded, "fooba"));
+        static_assert(Equals("Zm9vYmE"_unb64, "fooba"));
+
+        CHECK(Equals("Man is distinguished"_b64, "TWFuIGlzIGRpc3Rpbmd1aXNoZWQ="));
+    }
+#endif
+
+}
@@ -0,0 +1,135 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64Coroutine.hpp"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <deque>
+
+namespace {
+
+    // A single threaded event loop: suspended coroutines are queued and resumed in order.
+    struct EventLoop {
+        std::deque<std::coroutine_handle<>> m_ready;
+
+        void Run() {
+            while (!m_ready.empty()) {
+                auto handle = m_ready.front();
+                m_ready.pop_front();
+                handle.resume();
+            }
+        }
+    };
+
+    // Produces fixed chunks, suspending on every other read as a socket would when no data is ready.
+    struct ChunkSource {
+        EventLoop& m_loop;
+        std::vector<std::vector<uint8_t>> m_chunks;
+        size_t m_index = 0;
+
+        struct ReadAwaiter {
+            ChunkSource& m_source;
+
+            bool await_ready() const noexcept {
+                return m_source.m_index % 2 == 0;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const {
+                m_source.m_loop.m_ready.push_back(handle);
+            }
+
+            std::span<const uint8_t> await_resume() const noexcept {
+                size_t index = m_source.m_index++;
+                if (index >= m_source.m_chunks.size()) {
+                    return {};
+                }
+                return m_source.m_chunks[index];
+            }
+        };
+
+        ReadAwaiter next() {
+            return ReadAwaiter{ *this };
+        }
+    };
+
+    // A coroutine which starts immediately and destroys itself when finished.
+    struct Task {
+        struct promise_type {
+            Task get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    Task collect(base64::AsyncGenerator<std::span<const uint8_t>> stream, std::vector<std::vector<uint8_t>>& pieces, bool& finished) {
+        while (auto piece = co_await stream.next()) {
+            pieces.emplace_back(piece->begin(), piece->end());
+        }
+        finished = true;
+    }
+
+    struct Base64CoroutineTest {
+        // Splits data into chunks of the given lengths, encodes them as a stream and checks that every
+        // piece is whole groups and that the pieces join to the one-shot encoding.
+        static bool TestChunks(const std::vector<size_t>& lengths, bool padded) {
+            size_t total = 0;
+            for (size_t length : lengths) {
+                total += length;
+            }
+            auto data = test_data::MakeBinary(total);
+
+            EventLoop loop;
+            ChunkSource source{ loop, {} };
+            size_t offset = 0;
+            for (size_t length : lengths) {
+                source.m_chunks.emplace_back(data.begin() + static_cast<std::ptrdiff_t>(offset), data.begin() + static_cast<std::ptrdiff_t>(offset + length));
+                offset += length;
+            }
+
+            std::vector<std::vector<uint8_t>> pieces;
+            bool finished = false;
+            collect(base64::encode_stream(source, padded), pieces, finished);
+            loop.Run();
+
+            std::vector<uint8_t> joined;
+            for (size_t i = 0; i < pieces.size(); ++i) {
+                if (pieces[i].empty() || (i + 1 < pieces.size() && pieces[i].size() % 4 != 0)) {
+                    return false;
+                }
+                joined.insert(joined.end(), pieces[i].begin(), pieces[i].end());
+            }
+            return finished && joined == base64::encode_to_byte_vector(data.data(), data.size(), padded);
+        }
+    };
+}
+
+namespace base64coroutine_test {
+
+    TEST_CASE(Base64CoroutineTest, EncodeStream) {
+        SECTION("Empty stream") {
+            CHECK(TestChunks({}, true));
+        }
+
+        SECTION("Whole groups") {
+            CHECK(TestChunks({ 3 }, true));
+            CHECK(TestChunks({ 48, 96, 3000 }, true));
+        }
+
+        SECTION("Leftover bytes carried between chunks") {
+            CHECK(TestChunks({ 1 }, true));
+            CHECK(TestChunks({ 2 }, false));
+            CHECK(TestChunks({ 1, 1, 1, 1, 1 }, true));
+            CHECK(TestChunks({ 1, 100, 2, 7, 1000, 5 }, true));
+            CHECK(TestChunks({ 4, 4, 4, 4 }, false));
+        }
+
+        SECTION("Large chunks") {
+            CHECK(TestChunks({ 100000, 65537, 1 }, true));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64.hpp"
+
+namespace {
+
+    struct Base64DispatchTest {
+        Base64DispatchTest()
+          : m_original(base64::get_dispatch_table())
+        {}
+
+        ~Base64DispatchTest() {
+            base64::set_dispatch_table(m_original);
+        }
+
+        static bool TestRoundTrip(size_t length) {
+            auto source = test_data::MakeBinary(length);
+
+            auto expected = base64::encode_to_string(source.data(), length, true, base64::Codepath::Basic);
+            auto encoded = base64::encode_to_string(source.data(), length);
+            if (encoded != expected) {
+                return false;
+            }
+
+            auto decoded = base64::decode_to_vector(reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size());
+            return decoded == source;
+        }
+
+    private:
+        base64::DispatchTable m_original;
+    };
+}
+
+namespace base64dispatch_test {
+
+    TEST_CASE(Base64DispatchTest, DefaultTable) {
+        auto table = base64::make_default_dispatch_table();
+        CHECK(table.encode[0] == base64::Codepath::Basic);
+        CHECK(table.decode[0] == base64::Codepath::Basic);
+        CHECK(table.size_limits[0] == 24);
+
+        SECTION("Size classes") {
+            CHECK(base64::get_size_class(0) == base64::SizeClass::Tiny);
+            CHECK(base64::get_size_class(23) == base64::SizeClass::Tiny);
+            CHECK(base64::get_size_class(24) == base64::SizeClass::Short);
+            CHECK(base64::get_size_class(511) == base64::SizeClass::Short);
+            CHECK(base64::get_size_class(512) == base64::SizeClass::Medium);
+            CHECK(base64::get_size_class(65536) == base64::SizeClass::Large);
+        }
+
+        SECTION("Prefer SSSE3 for short inputs") {
+            auto ssse3_table = base64::make_default_dispatch_table(true);
+            if (base64::is_codepath_supported(base64::Codepath::AVX2)) {
+                CHECK(ssse3_table.encode[1] == base64::Codepath::SSSE3);
+                CHECK(ssse3_table.decode[1] == base64::Codepath::SSSE3);
+                CHECK(ssse3_table.encode[3] == base64::Codepath::AVX2);
+            }
+        }
+    }
+
+    TEST_CASE(Base64DispatchTest, SetTable) {
+        SECTION("Custom thresholds") {
+            auto table = base64::make_default_dispatch_table();
+            table.size_limits = { 4, 32, 128 };
+            base64::set_dispatch_table(table);
+
+            CHECK(base64::get_size_class(3) == base64::SizeClass::Tiny);
+            CHECK(base64::get_size_class(100) == base64::SizeClass::Medium);
+            for (size_t length = 0; length < 300; ++length) {
+                CHECK(TestRoundTrip(length));
+            }
+        }
+
+        SECTION("Invalid tables") {
+            auto table = base64::make_default_dispatch_table();
+            table.size_limits = { 64, 32, 128 };
+            CHECK_THROW(std::invalid_argument, base64::set_dispatch_table(table));
+
+            table = base64::make_default_dispatch_table();
+            table.encode[2] = base64::Codepath::Auto;
+            CHECK_THROW(std::invalid_argument, base64::set_dispatch_table(table));
+
+            if (base64::is_codepath_supported(base64::Codepath::SSSE3)) {
+                table = base64::make_default_dispatch_table();
+                table.encode[0] = base64::Codepath::SSSE3;
+                CHECK_THROW(std::invalid_argument, base64::set_dispatch_table(table));
+
+                table = base64::make_default_dispatch_table();
+                table.decode[0] = base64::Codepath::SSSE3;
+                CHECK_THROW(std::invalid_argument, base64::set_dispatch_table(table));
+            }
+        }
+    }
+
+    TEST_CASE(Base64DispatchTest, RoundTrip) {
+        for (size_t length = 0; length < 1024; ++length) {
+            CHECK(TestRoundTrip(length));
+        }
+        CHECK(TestRoundTrip(100000));
+    }
+
+}
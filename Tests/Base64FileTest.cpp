@@ -0,0 +1,112 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64File.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+    struct Base64FileTest {
+        Base64FileTest()
+          : m_directory(std::filesystem::temp_directory_path() / ("base64_file_test_" + std::to_string(::getpid())))
+        {
+            std::filesystem::create_directories(m_directory);
+        }
+
+        ~Base64FileTest() {
+            std::error_code error;
+            std::filesystem::remove_all(m_directory, error);
+        }
+
+        std::string GetPath(const std::string& name) const {
+            return (m_directory / name).string();
+        }
+
+        static void WriteFile(const std::string& path, const std::vector<uint8_t>& data) {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+
+        static std::vector<uint8_t> ReadFile(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        bool TestRoundTrip(size_t length, const base64::FileOptions& options) const {
+            auto source = test_data::MakeBinary(length);
+            WriteFile(GetPath("source.bin"), source);
+
+            base64::encode_file(GetPath("source.bin"), GetPath("encoded.txt"), options);
+            if (ReadFile(GetPath("encoded.txt")) != base64::encode_to_byte_vector(source.data(), length, options.padded)) {
+                return false;
+            }
+
+            base64::decode_file(GetPath("encoded.txt"), GetPath("decoded.bin"), options);
+            return ReadFile(GetPath("decoded.bin")) == source;
+        }
+
+    private:
+        std::filesystem::path m_directory;
+    };
+}
+
+namespace base64file_test {
+
+    TEST_CASE(Base64FileTest, RoundTrip) {
+        SECTION("Single thread") {
+            base64::FileOptions options;
+            for (size_t length : { 0, 1, 2, 3, 4, 100, 4096, 100001 }) {
+                CHECK(TestRoundTrip(length, options));
+            }
+        }
+
+        SECTION("Unpadded") {
+            base64::FileOptions options;
+            options.padded = false;
+            for (size_t length : { 1, 2, 3, 1000 }) {
+                CHECK(TestRoundTrip(length, options));
+            }
+        }
+
+        SECTION("Multiple threads") {
+            base64::FileOptions options;
+            options.threads = 4;
+            options.min_bytes_per_thread = 1000;
+            for (size_t length : { 10, 3999, 4000, 4001, 1000000 }) {
+                CHECK(TestRoundTrip(length, options));
+            }
+        }
+    }
+
+    TEST_CASE(Base64FileTest, Decode) {
+        SECTION("Trailing line break") {
+            std::string encoded = "Zm9vYmFy\r\n";
+            WriteFile(GetPath("encoded.txt"), std::vector<uint8_t>(encoded.begin(), encoded.end()));
+            base64::decode_file(GetPath("encoded.txt"), GetPath("decoded.bin"));
+
+            auto decoded = ReadFile(GetPath("decoded.bin"));
+            CHECK(std::string(decoded.begin(), decoded.end()) == "foobar");
+        }
+
+        SECTION("Missing file") {
+            CHECK_THROW(std::system_error, base64::decode_file(GetPath("missing.txt"), GetPath("decoded.bin")));
+            CHECK_THROW(std::system_error, base64::encode_file(GetPath("missing.bin"), GetPath("encoded.txt")));
+        }
+    }
+
+    TEST_CASE(Base64FileTest, SameFile) {
+        auto source = test_data::MakeBinary(1000);
+        WriteFile(GetPath("source.bin"), source);
+        std::filesystem::create_hard_link(GetPath("source.bin"), GetPath("hard_link.bin"));
+        std::filesystem::create_symlink(GetPath("source.bin"), GetPath("symlink.bin"));
+
+        for (const char* dest : { "source.bin", "hard_link.bin", "symlink.bin" }) {
+            CHECK_THROW(std::system_error, base64::encode_file(GetPath("source.bin"), GetPath(dest)));
+            CHECK_THROW(std::system_error, base64::decode_file(GetPath("source.bin"), GetPath(dest)));
+            CHECK(ReadFile(GetPath("source.bin")) == source);
+        }
+    }
+}
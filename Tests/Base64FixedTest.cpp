@@ -0,0 +1,97 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64.hpp"
+
+namespace {
+
+    struct Base64FixedTest {
+        static constexpr std::array<base64::Codepath, 3> Codepaths = {
+            base64::Codepath::Basic,
+            base64::Codepath::SSSE3,
+            base64::Codepath::AVX2
+        };
+
+        template <size_t N>
+        static std::array<uint8_t, N> MakeSource() {
+            auto binary = test_data::MakeBinary(N);
+            std::array<uint8_t, N> source;
+            std::copy(binary.begin(), binary.end(), source.begin());
+            return source;
+        }
+
+        template <size_t N, bool Padded>
+        static bool TestRoundTrip(base64::Codepath codepath) {
+            auto source = MakeSource<N>();
+            auto expected = base64::encode_to_string(source.data(), N, Padded, base64::Codepath::Basic);
+
+            auto encoded = base64::encode_fixed<N, Padded>(source.data(), codepath);
+            if (std::string(encoded.begin(), encoded.end()) != expected) {
+                return false;
+            }
+
+            auto decoded = base64::decode_fixed<N>(reinterpret_cast<const uint8_t*>(encoded.data()), codepath);
+            return decoded == source;
+        }
+
+        template <size_t N>
+        static bool TestSize(base64::Codepath codepath) {
+            return TestRoundTrip<N, true>(codepath) && TestRoundTrip<N, false>(codepath);
+        }
+    };
+}
+
+namespace base64fixed_test {
+
+    TEST_CASE(Base64FixedTest, Encode) {
+        SECTION("Known values") {
+            std::array<uint8_t, 6> source = { 'f', 'o', 'o', 'b', 'a', 'r' };
+            auto encoded = base64::encode_fixed(source);
+            CHECK_EQUAL(std::string(encoded.begin(), encoded.end()), "Zm9vYmFy");
+
+            std::array<uint8_t, 4> short_source = { 'f', 'o', 'o', 'b' };
+            auto padded = base64::encode_fixed(short_source);
+            CHECK_EQUAL(std::string(padded.begin(), padded.end()), "Zm9vYg==");
+
+            auto unpadded = base64::encode_fixed<false>(short_source);
+            CHECK_EQUAL(std::string(unpadded.begin(), unpadded.end()), "Zm9vYg");
+        }
+
+        SECTION("Array sizes") {
+            static_assert(std::tuple_size_v<decltype(base64::encode_fixed<16>(nullptr))> == 24);
+            static_assert(std::tuple_size_v<decltype(base64::encode_fixed<20>(nullptr))> == 28);
+            static_assert(std::tuple_size_v<decltype(base64::encode_fixed<20, false>(nullptr))> == 27);
+            static_assert(std::tuple_size_v<decltype(base64::encode_fixed<32>(nullptr))> == 44);
+            static_assert(std::tuple_size_v<decltype(base64::encode_fixed<64>(nullptr))> == 88);
+        }
+    }
+
+    TEST_CASE(Base64FixedTest, RoundTrip) {
+        for (auto codepath : Codepaths) {
+            CHECK(TestSize<1>(codepath));
+            CHECK(TestSize<2>(codepath));
+            CHECK(TestSize<3>(codepath));
+            CHECK(TestSize<12>(codepath));
+            CHECK(TestSize<16>(codepath));
+            CHECK(TestSize<20>(codepath));
+            CHECK(TestSize<24>(codepath));
+            CHECK(TestSize<32>(codepath));
+            CHECK(TestSize<33>(codepath));
+            CHECK(TestSize<64>(codepath));
+        }
+    }
+
+    TEST_CASE(Base64FixedTest, Decode) {
+        SECTION("Padded and unpadded") {
+            std::string_view padded = "Zm9vYg==";
+            std::string_view unpadded = "Zm9vYg";
+
+            std::array<uint8_t, 4> expected = { 'f', 'o', 'o', 'b' };
+            for (auto codepath : Codepaths) {
+                CHECK(base64::decode_fixed<4>(reinterpret_cast<const uint8_t*>(padded.data()), codepath) == expected);
+                CHECK(base64::decode_fixed<4>(reinterpret_cast<const uint8_t*>(unpadded.data()), codepath) == expected);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,124 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64Jwt.hpp"
+
+namespace {
+
+    struct Base64JwtTest {
+        std::vector<uint8_t> m_claims;
+        std::vector<uint8_t> m_signature;
+
+        base64::JwtSegments Decode(const std::string& token) {
+            m_claims.assign(base64::get_jwt_decoded_length_bound(token.size()), 0);
+            m_signature.assign(base64::get_jwt_decoded_length_bound(token.size()), 0);
+            return base64::decode_jwt(
+                reinterpret_cast<const uint8_t*>(token.data()),
+                token.size(),
+                m_claims.data(),
+                m_claims.size(),
+                m_signature.data(),
+                m_signature.size()
+            );
+        }
+
+        static std::string ToString(const base64::ConstSegment& segment) {
+            return std::string(reinterpret_cast<const char*>(segment.data), segment.length);
+        }
+
+        // Encodes `text` as unpadded base64url.
+        static std::string EncodeUrl(const std::string& text) {
+            std::string encoded = base64::encode_to_string(reinterpret_cast<const uint8_t*>(text.data()), text.size(), false);
+            for (auto& c : encoded) {
+                c = (c == '+') ? '-' : (c == '/') ? '_' : c;
+            }
+            return encoded;
+        }
+    };
+}
+
+namespace base64jwt_test {
+
+    TEST_CASE(Base64JwtTest, DecodeJwt) {
+        SECTION("Example token") {
+            std::string token =
+                "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9"
+                ".eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwiaWF0IjoxNTE2MjM5MDIyfQ"
+                ".SflKxwRJSMeKKF2QT4fwpMeJf36POk6yJV_adQssw5c";
+            auto segments = Decode(token);
+            CHECK(ToString(segments.header) == R"({"alg":"HS256","typ":"JWT"})");
+            CHECK(ToString(segments.payload) == R"({"sub":"1234567890","name":"John Doe","iat":1516239022})");
+            CHECK(ToString(segments.signing_input) == token.substr(0, token.rfind('.')));
+            CHECK(segments.header.data == m_claims.data());
+            CHECK(segments.payload.data == m_claims.data() + segments.header.length);
+
+            const std::vector<uint8_t> signature = {
+                0x49, 0xf9, 0x4a, 0xc7, 0x04, 0x49, 0x48, 0xc7, 0x8a, 0x28, 0x5d, 0x90, 0x4f, 0x87, 0xf0, 0xa4,
+                0xc7, 0x89, 0x7f, 0x7e, 0x8f, 0x3a, 0x4e, 0xb2, 0x25, 0x5f, 0xda, 0x75, 0x0b, 0x2c, 0xc3, 0x97
+            };
+            CHECK(std::vector<uint8_t>(segments.signature.data, segments.signature.data + segments.signature.length) == signature);
+        }
+
+        SECTION("Long segments") {
+            // Payloads spanning several blocks, with every length of final group, and every character.
+            for (size_t length : { 3000, 3001, 3002 }) {
+                std::string payload;
+                for (size_t i = 0; i < length; ++i) {
+                    payload += static_cast<char>(i * 7);
+                }
+                auto segments = Decode(EncodeUrl("{}") + "." + EncodeUrl(payload) + "." + EncodeUrl(payload.substr(0, 300)));
+                CHECK(ToString(segments.header) == "{}");
+                CHECK(ToString(segments.payload) == payload);
+                CHECK(ToString(segments.signature) == payload.substr(0, 300));
+            }
+        }
+
+        SECTION("Exact buffers") {
+            // The decoded data fills the buffers exactly, so nothing may be written past them.
+            for (size_t length : { 1, 2, 3, 23, 24, 25, 47, 48, 49, 1500 }) {
+                std::string payload(length, 'x');
+                std::string token = EncodeUrl("{}") + "." + EncodeUrl(payload) + "." + EncodeUrl(payload);
+                std::vector<uint8_t> claims(2 + length);
+                std::vector<uint8_t> signature(length);
+                for (auto codepath : { base64::Codepath::Auto, base64::Codepath::Basic }) {
+                    auto segments = base64::decode_jwt(reinterpret_cast<const uint8_t*>(token.data()), token.size(), claims.data(), claims.size(), signature.data(), signature.size(), codepath);
+                    CHECK(ToString(segments.payload) == payload);
+                    CHECK(ToString(segments.signature) == payload);
+                }
+            }
+        }
+
+        SECTION("Empty payload and signature") {
+            auto segments = Decode("e30..");
+            CHECK(ToString(segments.header) == "{}");
+            CHECK(segments.payload.length == 0);
+            CHECK(segments.signature.length == 0);
+        }
+    }
+
+    TEST_CASE(Base64JwtTest, Validation) {
+        SECTION("Invalid tokens") {
+            std::string signature = EncodeUrl(std::string(64, '\xff'));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30"));
+            CHECK_THROW(std::invalid_argument, Decode(".e30.e30"));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30." + signature + ".e30"));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30=." + signature));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30." + signature + "+"));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30." + signature.substr(0, 40) + "/" + signature.substr(41)));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30AA." + signature));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30.YR"));
+            CHECK_THROW(std::invalid_argument, Decode("e30.e30.YWF"));
+            CHECK_NO_THROW(Decode("e30.e30.YQ"));
+            CHECK_NO_THROW(Decode("e30.e30.YWE"));
+        }
+
+        SECTION("Buffer too small") {
+            std::string token = "e30.e30.YWE";
+            uint8_t claims[4];
+            uint8_t signature[2];
+            auto data = reinterpret_cast<const uint8_t*>(token.data());
+            CHECK_THROW(std::logic_error, base64::decode_jwt(data, token.size(), claims, 3, signature, 2));
+            CHECK_THROW(std::logic_error, base64::decode_jwt(data, token.size(), claims, 4, signature, 1));
+            CHECK_NO_THROW(base64::decode_jwt(data, token.size(), claims, 4, signature, 2));
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64LineIndex.hpp"
+
+namespace {
+
+    struct Base64LineIndexTest {
+        std::vector<uint8_t> m_binary;
+        std::vector<uint8_t> m_wrapped;
+
+        // Encodes `length` bytes and wraps the encoding with the given line lengths, used in turn.
+        void MakeWrapped(size_t length, const std::vector<size_t>& line_lengths, const std::string& line_break) {
+            m_binary = test_data::MakeBinary(length);
+            auto encoded = base64::encode_to_byte_vector(m_binary.data(), length);
+
+            m_wrapped.clear();
+            size_t line = 0;
+            for (size_t offset = 0; offset < encoded.size(); ++line) {
+                size_t count = std::min(line_lengths[line % line_lengths.size()], encoded.size() - offset);
+                m_wrapped.insert(m_wrapped.end(), encoded.begin() + static_cast<std::ptrdiff_t>(offset), encoded.begin() + static_cast<std::ptrdiff_t>(offset + count));
+                m_wrapped.insert(m_wrapped.end(), line_break.begin(), line_break.end());
+                offset += count;
+            }
+        }
+
+        // Builds an index from pieces of the given size.
+        base64::LineIndex BuildIndex(size_t sample_interval, size_t piece_size) const {
+            base64::LineIndex index(sample_interval);
+            for (size_t offset = 0; offset < m_wrapped.size(); offset += piece_size) {
+                index.Append(m_wrapped.data() + offset, std::min(piece_size, m_wrapped.size() - offset));
+            }
+            return index;
+        }
+
+        bool TestRanges(const base64::LineIndex& index) const {
+            if (index.GetDecodedLength(m_wrapped.data()) != m_binary.size()) {
+                return false;
+            }
+
+            std::vector<uint8_t> slice;
+            for (size_t offset = 0; offset <= m_binary.size(); offset += 7) {
+                for (size_t length : { size_t(0), size_t(1), size_t(2), size_t(3), size_t(50), m_binary.size() }) {
+                    length = std::min(length, m_binary.size() - offset);
+                    slice.assign(length, 0);
+                    index.DecodeRange(m_wrapped.data(), offset, length, slice.data());
+                    if (!std::equal(slice.begin(), slice.end(), m_binary.begin() + static_cast<std::ptrdiff_t>(offset))) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+}
+
+namespace base64lineindex_test {
+
+    TEST_CASE(Base64LineIndexTest, DecodeRange) {
+        SECTION("Fixed line length") {
+            MakeWrapped(1000, { 76 }, "\n");
+            CHECK(TestRanges(BuildIndex(base64::LineIndex::DefaultSampleInterval, 4096)));
+            CHECK(TestRanges(BuildIndex(100, 4096)));
+        }
+
+        SECTION("CRLF and variable line lengths") {
+            MakeWrapped(2000, { 64, 3, 17, 1, 200 }, "\r\n");
+            CHECK(TestRanges(BuildIndex(33, 4096)));
+            CHECK(TestRanges(BuildIndex(64, 5)));
+        }
+
+        SECTION("Unwrapped and short") {
+            for (size_t length : { 0, 1, 2, 3, 4, 5 }) {
+                MakeWrapped(length, { 1000 }, "");
+                CHECK(TestRanges(BuildIndex(2, 1)));
+            }
+        }
+    }
+
+    TEST_CASE(Base64LineIndexTest, FileOffset) {
+        SECTION("Characters map to their file position") {
+            MakeWrapped(600, { 76 }, "\r\n");
+            auto index = BuildIndex(50, 13);
+            CHECK(index.GetCharacterCount() == 800);
+            CHECK(index.GetLength() == m_wrapped.size());
+
+            for (size_t character = 0; character < 800; character += 3) {
+                CHECK(index.GetFileOffset(m_wrapped.data(), character) == character + (character / 76) * 2);
+            }
+            CHECK(index.GetFileOffset(m_wrapped.data(), 800) == m_wrapped.size());
+            CHECK_THROW(std::out_of_range, index.GetFileOffset(m_wrapped.data(), 801));
+        }
+    }
+
+    TEST_CASE(Base64LineIndexTest, Serialize) {
+        SECTION("Round trip") {
+            MakeWrapped(3000, { 64 }, "\n");
+
+            // Serialize half way through and append the rest to the restored index.
+            size_t half = m_wrapped.size() / 2;
+            base64::LineIndex partial(128);
+            partial.Append(m_wrapped.data(), half);
+
+            auto serialized = partial.Serialize();
+            auto restored = base64::LineIndex::Deserialize(serialized.data(), serialized.size());
+            restored.Append(m_wrapped.data() + half, m_wrapped.size() - half);
+            CHECK(TestRanges(restored));
+        }
+
+        SECTION("Invalid data") {
+            std::vector<uint8_t> garbage(40, 1);
+            CHECK_THROW(std::invalid_argument, base64::LineIndex::Deserialize(garbage.data(), garbage.size()));
+
+            auto serialized = base64::LineIndex(16).Serialize();
+            serialized.pop_back();
+            CHECK_THROW(std::invalid_argument, base64::LineIndex::Deserialize(serialized.data(), serialized.size()));
+        }
+    }
+}
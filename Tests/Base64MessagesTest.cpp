@@ -0,0 +1,86 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64Messages.hpp"
+
+namespace {
+
+    struct Base64MessagesTest {
+        static std::vector<std::vector<uint8_t>> MakeMessages(const std::vector<size_t>& lengths) {
+            std::vector<std::vector<uint8_t>> messages(lengths.size());
+            for (size_t i = 0; i < lengths.size(); ++i) {
+                messages[i].resize(lengths[i]);
+                for (size_t j = 0; j < lengths[i]; ++j) {
+                    messages[i][j] = static_cast<uint8_t>(i * 31 + j * 7 + 1);
+                }
+            }
+            return messages;
+        }
+
+        // Encodes and decodes the messages together, checking each against `encode_to_byte_vector`.
+        static bool TestRoundTrip(const std::vector<size_t>& lengths, bool padded, base64::Codepath codepath) {
+            auto messages = MakeMessages(lengths);
+
+            std::vector<std::vector<uint8_t>> encoded(messages.size());
+            std::vector<base64::ConstSegment> sources;
+            std::vector<base64::Segment> dests;
+            for (size_t i = 0; i < messages.size(); ++i) {
+                encoded[i].resize(base64::get_encoded_length(messages[i].size(), padded));
+                sources.push_back({ messages[i].data(), messages[i].size() });
+                dests.push_back({ encoded[i].data(), encoded[i].size() });
+            }
+            base64::encode_messages(sources.data(), dests.data(), messages.size(), padded, codepath);
+
+            std::vector<std::vector<uint8_t>> decoded(messages.size());
+            std::vector<base64::ConstSegment> encoded_sources;
+            std::vector<base64::Segment> decoded_dests;
+            for (size_t i = 0; i < messages.size(); ++i) {
+                if (encoded[i] != base64::encode_to_byte_vector(messages[i].data(), messages[i].size(), padded)) {
+                    return false;
+                }
+                decoded[i].resize(messages[i].size());
+                encoded_sources.push_back({ encoded[i].data(), encoded[i].size() });
+                decoded_dests.push_back({ decoded[i].data(), decoded[i].size() });
+            }
+            base64::decode_messages(encoded_sources.data(), decoded_dests.data(), messages.size(), codepath);
+
+            return decoded == messages;
+        }
+    };
+}
+
+namespace base64messages_test {
+
+    TEST_CASE(Base64MessagesTest, RoundTrip) {
+        SECTION("Tiny messages") {
+            std::vector<size_t> lengths;
+            for (size_t i = 0; i < 1000; ++i) {
+                lengths.push_back(i % 65);
+            }
+            for (auto codepath : { base64::Codepath::Auto, base64::Codepath::Basic }) {
+                CHECK(TestRoundTrip(lengths, true, codepath));
+                CHECK(TestRoundTrip(lengths, false, codepath));
+            }
+        }
+
+        SECTION("Mixed with long messages") {
+            // Long messages are transcoded alone, including at the start and end and back to back.
+            std::vector<size_t> lengths = { 300, 5, 16, 1000, 2000, 0, 32, 63, 64, 7, 4096 };
+            CHECK(TestRoundTrip(lengths, true, base64::Codepath::Auto));
+            CHECK(TestRoundTrip(lengths, false, base64::Codepath::Auto));
+        }
+
+        SECTION("No messages") {
+            CHECK(TestRoundTrip({}, true, base64::Codepath::Auto));
+        }
+    }
+
+    TEST_CASE(Base64MessagesTest, IncorrectSize) {
+        SECTION("Dest buffers") {
+            uint8_t data[8] = {};
+            base64::ConstSegment source = { data, 3 };
+            base64::Segment dest = { data + 3, 3 };
+            CHECK_THROW(std::logic_error, base64::encode_messages(&source, &dest, 1));
+            CHECK_THROW(std::logic_error, base64::decode_messages(&source, &dest, 1));
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64Pipeline.hpp"
+
+namespace {
+
+    struct Base64PipelineTest {
+        static bool TestEncode(size_t length, size_t block_size, bool padded) {
+            auto source = test_data::MakeBinary(length);
+            auto expected = base64::encode_to_byte_vector(source.data(), length, padded);
+
+            base64::PipelineOptions options;
+            options.block_size = block_size;
+            options.padded = padded;
+
+            // Blocks arrive in order and cover the output exactly.
+            std::vector<uint8_t> consumed;
+            auto consume = [&](const uint8_t* data, size_t data_length) {
+                consumed.insert(consumed.end(), data, data + data_length);
+            };
+
+            base64::encode_blocks(source.data(), length, consume, options);
+            if (consumed != expected) {
+                return false;
+            }
+
+            consumed.clear();
+            std::vector<uint8_t> dest(expected.size());
+            base64::encode_blocks(source.data(), length, dest.data(), dest.size(), consume, options);
+            return consumed == expected && dest == expected;
+        }
+
+        static bool TestDecode(size_t length, size_t block_size, bool padded) {
+            auto expected = test_data::MakeBinary(length);
+            auto source = base64::encode_to_byte_vector(expected.data(), length, padded);
+
+            base64::PipelineOptions options;
+            options.block_size = block_size;
+
+            std::vector<uint8_t> consumed;
+            auto consume = [&](const uint8_t* data, size_t data_length) {
+                consumed.insert(consumed.end(), data, data + data_length);
+            };
+
+            base64::decode_blocks(source.data(), source.size(), consume, options);
+            if (consumed != expected) {
+                return false;
+            }
+
+            consumed.clear();
+            std::vector<uint8_t> dest(length);
+            base64::decode_blocks(source.data(), source.size(), dest.data(), dest.size(), consume, options);
+            return consumed == expected && dest == expected;
+        }
+    };
+}
+
+namespace base64pipeline_test {
+
+    TEST_CASE(Base64PipelineTest, Encode) {
+        SECTION("Small blocks") {
+            for (size_t length = 0; length < 200; ++length) {
+                CHECK(TestEncode(length, 1, true));
+                CHECK(TestEncode(length, 10, false));
+                CHECK(TestEncode(length, 48, true));
+            }
+        }
+
+        SECTION("Large buffers") {
+            CHECK(TestEncode(1000000, 64 * 1024, true));
+            CHECK(TestEncode(1000001, 100000, false));
+            CHECK(TestEncode(50000, 1 << 20, true));
+        }
+
+        SECTION("Incorrect dest size") {
+            auto source = test_data::MakeBinary(10);
+            std::vector<uint8_t> dest(10);
+            CHECK_THROW(std::logic_error, base64::encode_blocks(source.data(), source.size(), dest.data(), dest.size(), [](const uint8_t*, size_t) {}));
+        }
+    }
+
+    TEST_CASE(Base64PipelineTest, Decode) {
+        SECTION("Small blocks") {
+            for (size_t length = 0; length < 200; ++length) {
+                CHECK(TestDecode(length, 1, true));
+                CHECK(TestDecode(length, 10, false));
+                CHECK(TestDecode(length, 64, true));
+            }
+        }
+
+        SECTION("Large buffers") {
+            CHECK(TestDecode(1000000, 64 * 1024, true));
+            CHECK(TestDecode(1000001, 100000, false));
+            CHECK(TestDecode(50000, 1 << 20, true));
+        }
+    }
+}
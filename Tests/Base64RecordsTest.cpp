@@ -0,0 +1,96 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64Records.hpp"
+
+namespace {
+
+    struct Base64RecordsTest {
+        static std::vector<std::vector<uint8_t>> MakeRecords(size_t count) {
+            std::vector<std::vector<uint8_t>> records(count);
+            for (size_t i = 0; i < count; ++i) {
+                records[i].resize((i * 7) % 50);
+                for (size_t j = 0; j < records[i].size(); ++j) {
+                    records[i][j] = static_cast<uint8_t>(i * 17 + j * 3);
+                }
+            }
+            return records;
+        }
+
+        static std::string MakeLines(const std::vector<std::vector<uint8_t>>& records, const std::string& line_break, bool padded) {
+            std::string lines;
+            for (auto& record : records) {
+                lines += base64::encode_to_string(record.data(), record.size(), padded);
+                lines += line_break;
+            }
+            return lines;
+        }
+
+        static base64::RecordBatch Decode(const std::string& lines, const base64::RecordBatchOptions& options = {}) {
+            return base64::decode_records(reinterpret_cast<const uint8_t*>(lines.data()), lines.size(), options);
+        }
+
+        static bool Matches(const base64::RecordBatch& batch, const std::vector<std::vector<uint8_t>>& records) {
+            if (batch.size() != records.size() || batch.offsets.back() != batch.data.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < records.size(); ++i) {
+                auto begin = batch.data.begin() + static_cast<std::ptrdiff_t>(batch.offsets[i]);
+                auto end = batch.data.begin() + static_cast<std::ptrdiff_t>(batch.offsets[i + 1]);
+                if (!std::equal(begin, end, records[i].begin(), records[i].end())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+namespace base64records_test {
+
+    TEST_CASE(Base64RecordsTest, DecodeRecords) {
+        SECTION("LF and CRLF") {
+            auto records = MakeRecords(500);
+            CHECK(Matches(Decode(MakeLines(records, "\n", true)), records));
+            CHECK(Matches(Decode(MakeLines(records, "\r\n", false)), records));
+        }
+
+        SECTION("No final line break") {
+            auto lines = MakeLines(MakeRecords(3), "\n", true);
+            lines.pop_back();
+            CHECK(Matches(Decode(lines), MakeRecords(3)));
+            CHECK(Decode("").size() == 0);
+        }
+
+        SECTION("Empty lines") {
+            auto batch = Decode("Zm9v\n\n\r\nYg==\n");
+            CHECK(batch.size() == 4);
+            CHECK(batch.offsets == std::vector<uint64_t>({ 0, 3, 3, 3, 4 }));
+        }
+
+        SECTION("Multiple threads") {
+            auto records = MakeRecords(20000);
+            base64::RecordBatchOptions options;
+            options.threads = 4;
+            options.min_bytes_per_thread = 1000;
+            CHECK(Matches(Decode(MakeLines(records, "\r\n", true), options), records));
+        }
+    }
+
+    TEST_CASE(Base64RecordsTest, Validation) {
+        SECTION("Invalid records throw") {
+            CHECK_THROW(std::invalid_argument, Decode("Zm9v\nZm9v!A==\n"));
+            CHECK_THROW(std::invalid_argument, Decode("Zm9vY\n"));
+            CHECK_THROW(std::invalid_argument, Decode("Zm=v\n"));
+            CHECK_THROW(std::invalid_argument, Decode("Zm9vYmFyYmF6YmF6YmF6YmF6YmF6YmF6YmF6YmF6\x80\n"));
+        }
+
+        SECTION("Invalid records skipped") {
+            base64::RecordBatchOptions options;
+            options.skip_invalid = true;
+            auto batch = Decode("Zm9v\nZ m9v\nYmFy\nYQ=\n", options);
+            CHECK(batch.size() == 4);
+            CHECK(batch.invalid_records == std::vector<size_t>({ 1, 3 }));
+            CHECK(std::string(batch.data.begin(), batch.data.end()) == "foobar");
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64Segments.hpp"
+
+namespace {
+
+    struct Base64SegmentsTest {
+        // Splits `data` at the given segment lengths, the last segment taking whatever is left.
+        template<typename SegmentType, typename Pointer>
+        static std::vector<SegmentType> Split(Pointer data, size_t length, const std::vector<size_t>& lengths) {
+            std::vector<SegmentType> segments;
+            size_t offset = 0;
+            for (size_t segment_length : lengths) {
+                segment_length = std::min(segment_length, length - offset);
+                segments.push_back(SegmentType{ data + offset, segment_length });
+                offset += segment_length;
+            }
+            segments.push_back(SegmentType{ data + offset, length - offset });
+            return segments;
+        }
+
+        static bool TestRoundTrip(size_t length, const std::vector<size_t>& source_lengths, const std::vector<size_t>& dest_lengths, bool padded) {
+            auto data = test_data::MakeBinary(length);
+            auto expected = base64::encode_to_byte_vector(data.data(), length, padded);
+
+            std::vector<uint8_t> encoded(expected.size());
+            auto sources = Split<base64::ConstSegment>(static_cast<const uint8_t*>(data.data()), length, source_lengths);
+            auto dests = Split<base64::Segment>(encoded.data(), encoded.size(), dest_lengths);
+            if (base64::get_encoded_length(sources.data(), sources.size(), padded) != expected.size()) {
+                return false;
+            }
+            base64::encode(sources.data(), sources.size(), dests.data(), dests.size(), padded);
+            if (encoded != expected) {
+                return false;
+            }
+
+            // Decode with the segment layouts swapped.
+            std::vector<uint8_t> decoded(length);
+            auto encoded_segments = Split<base64::ConstSegment>(static_cast<const uint8_t*>(encoded.data()), encoded.size(), dest_lengths);
+            auto decoded_segments = Split<base64::Segment>(decoded.data(), length, source_lengths);
+            if (base64::get_decoded_length(encoded_segments.data(), encoded_segments.size()) != length) {
+                return false;
+            }
+            base64::decode(encoded_segments.data(), encoded_segments.size(), decoded_segments.data(), decoded_segments.size());
+            return decoded == data;
+        }
+    };
+}
+
+namespace base64segments_test {
+
+    TEST_CASE(Base64SegmentsTest, RoundTrip) {
+        SECTION("Single segment") {
+            for (size_t length : { 0, 1, 2, 3, 4, 100, 1000 }) {
+                CHECK(TestRoundTrip(length, {}, {}, true));
+                CHECK(TestRoundTrip(length, {}, {}, false));
+            }
+        }
+
+        SECTION("Groups spanning segments") {
+            CHECK(TestRoundTrip(10, { 1, 1, 1, 1 }, { 1, 2, 3 }, true));
+            CHECK(TestRoundTrip(100, { 2, 5, 0, 7, 31 }, { 5, 0, 9, 13 }, true));
+            CHECK(TestRoundTrip(101, { 2, 5, 7, 31 }, { 5, 9, 13 }, false));
+            CHECK(TestRoundTrip(1000, { 1, 1, 1 }, { 2, 2, 2, 2 }, true));
+        }
+
+        SECTION("Header and payload pages") {
+            CHECK(TestRoundTrip(3 * 4096 + 77, { 77, 4096, 4096 }, { 1000, 4096, 4096 }, true));
+            CHECK(TestRoundTrip(65537, { 64, 65000 }, { 87381 }, false));
+        }
+
+        SECTION("Padding split across segments") {
+            CHECK(TestRoundTrip(4, {}, { 7 }, true));
+            CHECK(TestRoundTrip(5, {}, { 6, 1 }, true));
+        }
+    }
+
+    TEST_CASE(Base64SegmentsTest, Errors) {
+        SECTION("Incorrect dest size") {
+            uint8_t source[3] = { 1, 2, 3 };
+            uint8_t dest[8];
+            base64::ConstSegment sources[] = { { source, 3 } };
+            base64::Segment dests[] = { { dest, 3 }, { dest + 3, 2 } };
+            CHECK_THROW(std::logic_error, base64::encode(sources, 1, dests, 2));
+        }
+    }
+
+#ifdef BASE64_HAS_IOVEC
+    TEST_CASE(Base64SegmentsTest, Iovec) {
+        SECTION("Encode into an iovec") {
+            std::string header = "head";
+            std::string payload = "er and payload";
+            iovec sources[] = { { header.data(), header.size() }, { payload.data(), payload.size() } };
+
+            std::string first(10, '\0');
+            std::string second(14, '\0');
+            iovec dests[] = { { first.data(), first.size() }, { second.data(), second.size() } };
+            base64::encode(sources, 2, dests, 2);
+            CHECK(first + second == base64::encode_to_string(reinterpret_cast<const uint8_t*>("header and payload"), 18));
+        }
+    }
+#endif
+}
@@ -0,0 +1,75 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64.hpp"
+
+namespace {
+
+    struct Base64StreamingTest {
+        Base64StreamingTest()
+          : m_original(base64::get_streaming_threshold())
+        {
+            base64::set_streaming_threshold(0);
+        }
+
+        ~Base64StreamingTest() {
+            base64::set_streaming_threshold(m_original);
+        }
+
+        // Round trips `length` octets through buffers offset by `offset` bytes from an aligned address, so
+        // that every alignment of the destination is covered.
+        static bool TestRoundTrip(base64::Codepath codepath, size_t length, size_t offset) {
+            auto source = test_data::MakeBinary(length);
+
+            auto expected = base64::encode_to_string(source.data(), length, true, base64::Codepath::Basic);
+
+            std::vector<uint8_t> encoded(expected.size() + 64);
+            uint8_t* encoded_ptr = AlignUp(encoded.data()) + offset;
+            base64::encode(source.data(), length, encoded_ptr, expected.size(), true, codepath);
+            if (std::memcmp(encoded_ptr, expected.data(), expected.size()) != 0) {
+                return false;
+            }
+
+            std::vector<uint8_t> decoded(length + 64);
+            uint8_t* decoded_ptr = AlignUp(decoded.data()) + offset;
+            base64::decode(encoded_ptr, expected.size(), decoded_ptr, length, codepath);
+            return std::memcmp(decoded_ptr, source.data(), length) == 0;
+        }
+
+    private:
+        size_t m_original;
+
+        static uint8_t* AlignUp(uint8_t* ptr) {
+            auto address = reinterpret_cast<uintptr_t>(ptr);
+            return ptr + ((32 - (address % 32)) % 32);
+        }
+    };
+}
+
+namespace base64streaming_test {
+
+    TEST_CASE(Base64StreamingTest, RoundTrip) {
+        base64::Codepath codepaths[] = { base64::Codepath::SSSE3, base64::Codepath::AVX2, base64::Codepath::Auto };
+        for (auto codepath : codepaths) {
+            if (!base64::is_codepath_supported(codepath)) {
+                continue;
+            }
+
+            for (size_t offset = 0; offset < 32; ++offset) {
+                for (size_t length = 0; length < 400; length += 7) {
+                    CHECK(TestRoundTrip(codepath, length, offset));
+                }
+                CHECK(TestRoundTrip(codepath, 100000, offset));
+            }
+        }
+    }
+
+    TEST_CASE(Base64StreamingTest, Threshold) {
+        CHECK(base64::get_streaming_threshold() == 0);
+
+        base64::set_streaming_threshold(1024);
+        CHECK(base64::get_streaming_threshold() == 1024);
+        CHECK(TestRoundTrip(base64::Codepath::Auto, 1023, 4));
+        CHECK(TestRoundTrip(base64::Codepath::Auto, 1024, 4));
+    }
+}
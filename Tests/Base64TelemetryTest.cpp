@@ -0,0 +1,109 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64.hpp"
+
+#include <thread>
+
+namespace {
+
+    struct Base64TelemetryTest {
+        Base64TelemetryTest() {
+            base64::reset_telemetry();
+        }
+    };
+}
+
+namespace base64telemetry_test {
+
+    TEST_CASE(Base64TelemetryTest, Counters) {
+        // The tests are built with BASE64_ENABLE_TELEMETRY defined.
+        REQUIRE(base64::TelemetryEnabled);
+
+        SECTION("Reset") {
+            auto source = test_data::MakeBinary(100);
+            base64::encode_to_string(source.data(), source.size());
+            base64::reset_telemetry();
+
+            auto telemetry = base64::get_telemetry();
+            CHECK(telemetry.encode.calls == 0);
+            CHECK(telemetry.encode.bytes == 0);
+            CHECK(telemetry.encode.size_histogram[7] == 0);
+        }
+
+        SECTION("Encode and decode") {
+            base64::reset_telemetry();
+            auto source = test_data::MakeBinary(100);
+            auto encoded = base64::encode_to_string(source.data(), source.size(), true, base64::Codepath::Basic);
+            base64::decode_to_vector(reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size(), base64::Codepath::Basic);
+
+            auto telemetry = base64::get_telemetry();
+            CHECK(telemetry.encode.calls == 1);
+            CHECK(telemetry.encode.bytes == 100);
+            CHECK(telemetry.encode.bulk_bytes == 0);
+            CHECK(telemetry.encode.scalar_bytes == 100);
+            CHECK(telemetry.encode.codepath_calls[static_cast<size_t>(base64::Codepath::Basic)] == 1);
+            CHECK(telemetry.encode.size_histogram[7] == 1);  // [64, 128)
+
+            CHECK(telemetry.decode.calls == 1);
+            CHECK(telemetry.decode.bytes == encoded.size());
+            CHECK(telemetry.decode.scalar_bytes == encoded.size());
+            CHECK(telemetry.decode.size_histogram[8] == 1);  // [128, 256)
+        }
+
+        SECTION("Bulk and scalar bytes") {
+            base64::reset_telemetry();
+            if (base64::is_codepath_supported(base64::Codepath::AVX2)) {
+                auto source = test_data::MakeBinary(100);
+                base64::encode_to_string(source.data(), source.size(), true, base64::Codepath::AVX2);
+
+                auto telemetry = base64::get_telemetry();
+                CHECK(telemetry.encode.codepath_calls[static_cast<size_t>(base64::Codepath::AVX2)] == 1);
+                CHECK(telemetry.encode.bulk_bytes == 96);
+                CHECK(telemetry.encode.scalar_bytes == 4);
+            }
+        }
+
+        SECTION("Auto records the codepath used") {
+            base64::reset_telemetry();
+            auto source = test_data::MakeBinary(4);
+            base64::encode_to_string(source.data(), source.size());
+
+            auto telemetry = base64::get_telemetry();
+            CHECK(telemetry.encode.codepath_calls[static_cast<size_t>(base64::Codepath::Auto)] == 0);
+            CHECK(telemetry.encode.codepath_calls[static_cast<size_t>(base64::Codepath::Basic)] == 1);
+        }
+
+        SECTION("Fixed-size values") {
+            base64::reset_telemetry();
+            std::array<uint8_t, 16> uuid = {};
+            base64::encode_fixed(uuid);
+
+            auto telemetry = base64::get_telemetry();
+            CHECK(telemetry.encode.calls == 1);
+            CHECK(telemetry.encode.bytes == 16);
+        }
+    }
+
+    TEST_CASE(Base64TelemetryTest, Threads) {
+        auto source = test_data::MakeBinary(10);
+
+        // Counters of exited threads are kept.
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 25; ++i) {
+                    base64::encode_to_string(source.data(), source.size());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        auto telemetry = base64::get_telemetry();
+        CHECK(telemetry.encode.calls == 100);
+        CHECK(telemetry.encode.bytes == 1000);
+        CHECK(telemetry.encode.size_histogram[4] == 100);  // [8, 16)
+    }
+}
@@ -21,6 +21,27 @@ namespace {
                 base64::Codepath::Basic
             );
         }
+
+        // Decodes every range of a long encoding and compares it with the matching slice of the source.
+        static bool TestDecodeRanges(size_t length, bool padded, base64::Codepath codepath) {
+            std::vector<uint8_t> source(length);
+            for (size_t i = 0; i < length; ++i) {
+                source[i] = static_cast<uint8_t>(i * 13 + 5);
+            }
+            auto encoded = base64::encode_to_byte_vector(source.data(), length, padded);
+
+            std::vector<uint8_t> slice;
+            for (size_t offset = 0; offset <= length; ++offset) {
+                for (size_t slice_length = 0; offset + slice_length <= length; slice_length += (slice_length < 8 ? 1 : 29)) {
+                    slice.assign(slice_length, 0);
+                    base64::decode_range(encoded.data(), encoded.size(), offset, slice_length, slice.data(), codepath);
+                    if (!std::equal(slice.begin(), slice.end(), source.begin() + static_cast<std::ptrdiff_t>(offset))) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
     };
 }
 
@@ -165,4 +186,25 @@ namespace base64_test {
         }
     }
 
-}
\ No newline at end of file
+    TEST_CASE(Base64Test, DecodeRange) {
+        SECTION("Every range") {
+            for (size_t length : { 0, 1, 2, 3, 4, 5, 6, 100 }) {
+                CHECK(TestDecodeRanges(length, true, base64::Codepath::Basic));
+                CHECK(TestDecodeRanges(length, false, base64::Codepath::Basic));
+            }
+            CHECK(TestDecodeRanges(301, true, base64::Codepath::Auto));
+            CHECK(TestDecodeRanges(302, false, base64::Codepath::Auto));
+        }
+
+        SECTION("Out of range") {
+            std::string encoded = "Zm9vYmE=";
+            auto data = reinterpret_cast<const uint8_t*>(encoded.data());
+            uint8_t dest[8];
+            CHECK_THROW(std::out_of_range, base64::decode_range(data, encoded.size(), 0, 6, dest));
+            CHECK_THROW(std::out_of_range, base64::decode_range(data, encoded.size(), 6, 1, dest));
+            base64::decode_range(data, encoded.size(), 3, 2, dest);
+            CHECK(dest[0] == 'b' && dest[1] == 'a');
+        }
+    }
+
+}
@@ -0,0 +1,68 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64Threads.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+
+    struct Base64ThreadsTest {
+        // Runs `count` indices, throwing from those in `failing`, and returns the message of the exception
+        // rethrown, or an empty string.  Sets `processed` to the number of indices which ran.
+        static std::string RunThreads(size_t count, std::vector<size_t> failing, size_t& processed) {
+            std::atomic<size_t> counter = 0;
+            try {
+                base64::detail::run_threads(count, [&](size_t index) {
+                    counter++;
+                    if (std::find(failing.begin(), failing.end(), index) != failing.end()) {
+                        throw std::runtime_error(std::to_string(index));
+                    }
+                });
+            } catch (const std::runtime_error& ex) {
+                processed = counter;
+                return ex.what();
+            }
+            processed = counter;
+            return {};
+        }
+    };
+}
+
+namespace base64threads_test {
+
+    TEST_CASE(Base64ThreadsTest, RunThreads) {
+        SECTION("Every index") {
+            std::vector<std::atomic<int>> calls(8);
+            base64::detail::run_threads(calls.size(), [&](size_t index) {
+                calls[index]++;
+            });
+            for (auto& count : calls) {
+                CHECK(count == 1);
+            }
+        }
+
+        SECTION("Exceptions") {
+            // Every thread is joined before the exception from the lowest index is rethrown.
+            size_t processed = 0;
+            CHECK(RunThreads(4, { 0 }, processed) == "0");
+            CHECK(processed == 4);
+            CHECK(RunThreads(4, { 3 }, processed) == "3");
+            CHECK(processed == 4);
+            CHECK(RunThreads(4, { 2, 1 }, processed) == "1");
+            CHECK(processed == 4);
+            CHECK(RunThreads(1, {}, processed).empty());
+            CHECK(processed == 1);
+        }
+    }
+
+    TEST_CASE(Base64ThreadsTest, GetThreadCount) {
+        SECTION("Limited by length") {
+            CHECK(base64::detail::get_thread_count(4, 0, 1000) == 1);
+            CHECK(base64::detail::get_thread_count(4, 2500, 1000) == 2);
+            CHECK(base64::detail::get_thread_count(4, 10000, 1000) == 4);
+            CHECK(base64::detail::get_thread_count(4, 10000, 0) == 4);
+            CHECK(base64::detail::get_thread_count(0, 10000, 1) >= 1);
+        }
+    }
+}
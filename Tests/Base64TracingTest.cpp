@@ -0,0 +1,64 @@
+#include "Tests/CppUnitTestFramework.hpp"
+
+#include "Base64.hpp"
+
+namespace {
+
+    std::vector<base64::TraceEvent> s_events;
+
+    struct Base64TracingTest {
+        Base64TracingTest() {
+            s_events.clear();
+            base64::set_trace_callback([](const base64::TraceEvent& event) {
+                s_events.push_back(event);
+            });
+        }
+
+        ~Base64TracingTest() {
+            base64::set_trace_callback(nullptr);
+        }
+    };
+}
+
+namespace base64tracing_test {
+
+    TEST_CASE(Base64TracingTest, Callback) {
+        // The tests are built with BASE64_ENABLE_TRACING defined.
+        REQUIRE(base64::TracingEnabled);
+
+        SECTION("Encode") {
+            s_events.clear();
+            std::vector<uint8_t> source(100, 7);
+            base64::encode_to_string(source.data(), source.size());
+
+            REQUIRE(s_events.size() == 2);
+            CHECK(s_events[0].point == base64::TracePoint::EncodeEntry);
+            CHECK(s_events[0].length == 100);
+            CHECK(s_events[0].codepath == base64::Codepath::Auto);
+            CHECK(s_events[1].point == base64::TracePoint::EncodeExit);
+            CHECK(s_events[1].length == 100);
+            CHECK(s_events[1].codepath == base64::get_dispatch_table().encode[1]);
+            CHECK(s_events[1].timestamp >= s_events[0].timestamp);
+        }
+
+        SECTION("Decode") {
+            s_events.clear();
+            std::string_view source = "Zm9vYmFy";
+            base64::decode_to_string(reinterpret_cast<const uint8_t*>(source.data()), source.size(), base64::Codepath::Basic);
+
+            REQUIRE(s_events.size() == 2);
+            CHECK(s_events[0].point == base64::TracePoint::DecodeEntry);
+            CHECK(s_events[0].length == 8);
+            CHECK(s_events[1].point == base64::TracePoint::DecodeExit);
+            CHECK(s_events[1].codepath == base64::Codepath::Basic);
+        }
+
+        SECTION("Unregistered") {
+            base64::set_trace_callback(nullptr);
+            s_events.clear();
+            std::vector<uint8_t> source(10, 7);
+            base64::encode_to_string(source.data(), source.size());
+            CHECK(s_events.empty());
+        }
+    }
+}
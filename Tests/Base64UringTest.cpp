@@ -0,0 +1,177 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64Uring.hpp"
+
+#if defined(BASE64_ENABLE_IO_URING) && defined(__linux__)
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+    struct Base64UringTest {
+        Base64UringTest()
+          : m_directory(std::filesystem::temp_directory_path() / ("base64_uring_test_" + std::to_string(::getpid())))
+        {
+            std::filesystem::create_directories(m_directory);
+        }
+
+        ~Base64UringTest() {
+            std::error_code error;
+            std::filesystem::remove_all(m_directory, error);
+        }
+
+        std::string GetPath(const std::string& name) const {
+            return (m_directory / name).string();
+        }
+
+        static void WriteFile(const std::string& path, const std::vector<uint8_t>& data) {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+
+        static std::vector<uint8_t> ReadFile(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        bool TestRoundTrip(size_t length, const base64::UringOptions& options) const {
+            auto source = test_data::MakeBinary(length);
+            WriteFile(GetPath("source.bin"), source);
+
+            base64::encode_file_async(GetPath("source.bin"), GetPath("encoded.txt"), options);
+            if (ReadFile(GetPath("encoded.txt")) != base64::encode_to_byte_vector(source.data(), length, options.padded)) {
+                return false;
+            }
+
+            base64::decode_file_async(GetPath("encoded.txt"), GetPath("decoded.bin"), options);
+            return ReadFile(GetPath("decoded.bin")) == source;
+        }
+
+    private:
+        std::filesystem::path m_directory;
+    };
+}
+
+namespace base64uring_test {
+
+    TEST_CASE(Base64UringTest, RoundTrip) {
+        // io_uring may be disabled by the kernel or blocked by a container's seccomp profile.
+        if (!base64::is_io_uring_available()) {
+            return;
+        }
+
+        SECTION("Default options") {
+            base64::UringOptions options;
+            for (size_t length : { 0, 1, 2, 3, 4, 100, 4096, 100001 }) {
+                CHECK(TestRoundTrip(length, options));
+            }
+        }
+
+        SECTION("Unpadded") {
+            base64::UringOptions options;
+            options.padded = false;
+            for (size_t length : { 1, 2, 3, 1000 }) {
+                CHECK(TestRoundTrip(length, options));
+            }
+        }
+
+        SECTION("Small chunks") {
+            // Many more chunks than slots, so slots are reused and writes complete out of order.
+            base64::UringOptions options;
+            options.chunk_size = 1000;
+            options.queue_depth = 3;
+            for (size_t length : { 999, 1000, 1001, 2999, 3000, 3001, 1000000 }) {
+                CHECK(TestRoundTrip(length, options));
+            }
+        }
+
+        SECTION("Queue depth of one") {
+            base64::UringOptions options;
+            options.chunk_size = 4096;
+            options.queue_depth = 1;
+            CHECK(TestRoundTrip(100000, options));
+        }
+    }
+
+    TEST_CASE(Base64UringTest, Decode) {
+        SECTION("Trailing line break") {
+            if (!base64::is_io_uring_available()) {
+                return;
+            }
+
+            std::string encoded = "Zm9vYmFy\r\n";
+            WriteFile(GetPath("encoded.txt"), std::vector<uint8_t>(encoded.begin(), encoded.end()));
+            WriteFile(GetPath("decoded.bin"), test_data::MakeBinary(1000));
+            base64::decode_file_async(GetPath("encoded.txt"), GetPath("decoded.bin"));
+
+            auto decoded = ReadFile(GetPath("decoded.bin"));
+            CHECK(std::string(decoded.begin(), decoded.end()) == "foobar");
+        }
+
+        SECTION("Missing file") {
+            CHECK_THROW(std::system_error, base64::decode_file_async(GetPath("missing.txt"), GetPath("decoded.bin")));
+            CHECK_THROW(std::system_error, base64::encode_file_async(GetPath("missing.bin"), GetPath("encoded.txt")));
+        }
+
+        SECTION("Same file") {
+            auto source = test_data::MakeBinary(1000);
+            WriteFile(GetPath("source.bin"), source);
+            std::filesystem::create_hard_link(GetPath("source.bin"), GetPath("hard_link.bin"));
+            std::filesystem::create_symlink(GetPath("source.bin"), GetPath("symlink.bin"));
+
+            for (const char* dest : { "source.bin", "hard_link.bin", "symlink.bin" }) {
+                CHECK_THROW(std::system_error, base64::encode_file_async(GetPath("source.bin"), GetPath(dest)));
+                CHECK_THROW(std::system_error, base64::decode_file_async(GetPath("source.bin"), GetPath(dest)));
+                CHECK(ReadFile(GetPath("source.bin")) == source);
+            }
+        }
+    }
+
+    TEST_CASE(Base64UringTest, Pipeline) {
+        SECTION("Exception while transcoding") {
+            if (!base64::is_io_uring_available()) {
+                return;
+            }
+
+            // Other chunks are still being read and written when one throws, and must finish before their
+            // buffers are freed.
+            WriteFile(GetPath("source.bin"), std::vector<uint8_t>(100000, 'x'));
+            base64::detail::FileDescriptor source_file(GetPath("source.bin"), O_RDONLY);
+            base64::detail::FileDescriptor dest_file(GetPath("dest.bin"), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            auto run = [&]() {
+                base64::detail::run_uring_pipeline(
+                    source_file.Get(), 100000,
+                    dest_file.Get(),
+                    1000, 1000,
+                    8,
+                    [](size_t chunk, const uint8_t* input, size_t length, uint8_t* output) -> size_t {
+                        if (chunk == 20) {
+                            throw std::runtime_error("Transcoding failed");
+                        }
+                        std::memcpy(output, input, length);
+                        return length;
+                    },
+                    [](size_t chunk) {
+                        return static_cast<uint64_t>(chunk * 1000);
+                    }
+                );
+            };
+            CHECK_THROW(std::runtime_error, run());
+        }
+
+        SECTION("Chunk size") {
+            // Neither a chunk nor its output may exceed what one operation can transfer.
+            CHECK(base64::detail::get_uring_chunk_size(0, 3) == 3);
+            CHECK(base64::detail::get_uring_chunk_size(1000, 3) == 999);
+            CHECK(base64::detail::get_uring_chunk_size(1000, 4) == 1000);
+            CHECK(base64::detail::get_uring_chunk_size(SIZE_MAX, 3) == size_t(0x3fffffff) * 3);
+            CHECK(base64::detail::get_uring_chunk_size(SIZE_MAX, 4) == size_t(0x3fffffff) * 4);
+            CHECK(base64::get_encoded_length(base64::detail::get_uring_chunk_size(SIZE_MAX, 3)) <= UINT32_MAX);
+        }
+    }
+}
+
+#endif
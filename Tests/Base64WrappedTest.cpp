@@ -0,0 +1,95 @@
+#include "Tests/CppUnitTestFramework.hpp"
+#include "Tests/TestData.hpp"
+
+#include "Base64Wrapped.hpp"
+
+namespace {
+
+    struct Base64WrappedTest {
+        // Encodes `binary` and wraps the encoding with the given line lengths, used in turn.
+        static std::vector<uint8_t> Wrap(const std::vector<uint8_t>& binary, const std::vector<size_t>& line_lengths, const std::string& line_break, bool padded) {
+            auto encoded = base64::encode_to_byte_vector(binary.data(), binary.size(), padded);
+
+            std::vector<uint8_t> wrapped;
+            size_t line = 0;
+            for (size_t offset = 0; offset < encoded.size(); ++line) {
+                size_t count = std::min(line_lengths[line % line_lengths.size()], encoded.size() - offset);
+                wrapped.insert(wrapped.end(), encoded.begin() + static_cast<std::ptrdiff_t>(offset), encoded.begin() + static_cast<std::ptrdiff_t>(offset + count));
+                wrapped.insert(wrapped.end(), line_break.begin(), line_break.end());
+                offset += count;
+            }
+            return wrapped;
+        }
+
+        // Encodes `length` bytes, wraps the encoding, and checks that decoding with the given options
+        // restores it.
+        static bool TestRoundTrip(size_t length, const std::vector<size_t>& line_lengths, const std::string& line_break, bool padded, const base64::WrappedDecodeOptions& options) {
+            auto binary = test_data::MakeBinary(length);
+            auto wrapped = Wrap(binary, line_lengths, line_break, padded);
+            return base64::decode_wrapped_to_vector(wrapped.data(), wrapped.size(), options) == binary;
+        }
+    };
+}
+
+namespace base64wrapped_test {
+
+    TEST_CASE(Base64WrappedTest, RoundTrip) {
+        SECTION("Single thread") {
+            base64::WrappedDecodeOptions options;
+            options.threads = 1;
+            for (size_t length : { 0, 1, 2, 3, 4, 57, 1000, 200000 }) {
+                CHECK(TestRoundTrip(length, { 76 }, "\r\n", true, options));
+                CHECK(TestRoundTrip(length, { 64 }, "\n", false, options));
+            }
+        }
+
+        SECTION("Piece boundaries inside groups") {
+            // Tiny pieces put boundaries at every position within groups and lines.
+            base64::WrappedDecodeOptions options;
+            options.min_bytes_per_thread = 1;
+            for (size_t threads : { 2, 3, 5, 8, 13 }) {
+                options.threads = threads;
+                for (size_t length : { 1, 2, 3, 10, 11, 100, 101 }) {
+                    CHECK(TestRoundTrip(length, { 76 }, "\r\n", true, options));
+                    CHECK(TestRoundTrip(length, { 1, 2, 3 }, " \n", false, options));
+                }
+            }
+        }
+
+        SECTION("Large input") {
+            base64::WrappedDecodeOptions options;
+            options.threads = 4;
+            options.min_bytes_per_thread = 1000;
+            CHECK(TestRoundTrip(1000001, { 76 }, "\r\n", true, options));
+            CHECK(TestRoundTrip(1000002, { 64, 1000, 3 }, "\n", false, options));
+        }
+    }
+
+    TEST_CASE(Base64WrappedTest, DecodeWrapped) {
+        SECTION("Into a buffer") {
+            for (size_t length : { 0, 1, 2, 3, 57, 3072, 3073, 100000 }) {
+                auto binary = test_data::MakeBinary(length);
+                auto wrapped = Wrap(binary, { 76 }, "\r\n", length % 2 == 0);
+                CHECK(base64::get_wrapped_decoded_length(wrapped.data(), wrapped.size()) == length);
+
+                std::vector<uint8_t> decoded(length + 10);
+                CHECK(base64::decode_wrapped(wrapped.data(), wrapped.size(), decoded.data(), decoded.size()) == length);
+                CHECK(std::equal(binary.begin(), binary.end(), decoded.begin()));
+            }
+        }
+
+        SECTION("In place") {
+            auto binary = test_data::MakeBinary(100000);
+            auto wrapped = Wrap(binary, { 1, 70, 3 }, " \n", true);
+            size_t length = base64::decode_wrapped(wrapped.data(), wrapped.size(), wrapped.data(), wrapped.size());
+            CHECK(length == binary.size());
+            CHECK(std::equal(binary.begin(), binary.end(), wrapped.begin()));
+        }
+
+        SECTION("Dest buffer too small") {
+            auto wrapped = Wrap(test_data::MakeBinary(100), { 76 }, "\n", true);
+            std::vector<uint8_t> decoded(99);
+            CHECK_THROW(std::logic_error, base64::decode_wrapped(wrapped.data(), wrapped.size(), decoded.data(), decoded.size()));
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Data shared by the test suites.
+
+namespace test_data {
+
+    // Returns `length` bytes of deterministic pseudo-random binary, different for each `seed`.  Unlike a
+    // linear sequence it doesn't repeat every 256 bytes, so identical blocks can't hide a bug in code which
+    // splits the data into lanes or pieces.
+    inline std::vector<uint8_t> MakeBinary(size_t length, uint64_t seed = 0) {
+        std::vector<uint8_t> binary(length);
+        uint64_t state = seed * 0x9e3779b97f4a7c15ull + 1;
+        for (auto& byte : binary) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            byte = static_cast<uint8_t>(state >> 56);
+        }
+        return binary;
+    }
+
+}